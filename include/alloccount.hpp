@@ -0,0 +1,15 @@
+#ifndef AllocCount_HPP
+#define AllocCount_HPP
+
+// Counts heap allocations made by each thread. Counting is only available in builds configured with
+// ENABLE_ALLOC_COUNT, which replace the global operator new; otherwise no allocations are reported.
+class AllocationCounter {
+public:
+	// Return true if allocations are being counted
+	static bool isEnabled();
+
+	// Number of allocations made by the calling thread since it started
+	static unsigned long long getAllocations();
+};
+
+#endif // ifndef AllocCount_HPP
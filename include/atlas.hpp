@@ -0,0 +1,8 @@
+#ifndef Atlas_HPP
+#define Atlas_HPP
+
+// Get the sprite atlas which was converted to RGBA and compiled into the game at build time (by ottsweeper_atlas).
+// Return false if the game was built without an atlas.
+bool getEmbeddedAtlas(const unsigned char*& data, int& width, int& height);
+
+#endif // ifndef Atlas_HPP
@@ -0,0 +1,55 @@
+#ifndef Background_HPP
+#define Background_HPP
+
+#include <vector>
+
+// Draws the window frame, beveled panels, and counter backgrounds with a fragment shader. Panels are
+// described by a handful of rectangles (in native pixels), so the cost does not depend on the size of
+// the minefield and nothing needs to be regenerated when the window is resized.
+class Background {
+public:
+	Background();
+
+	bool isReady() const {
+		return (nProgram != 0);
+	}
+
+	// Compile the shader program (requires OpenGL 3.3)
+	bool initialize();
+
+	// Set the native size of the window (in pixels)
+	void setScreenSize(const int& width, const int& height);
+
+	// Remove all panels
+	void clear();
+
+	// Add a panel with a three pixel bevel which appears raised (light top and left edges) or sunken.
+	// Corners are inclusive. Panels are drawn in the order they were added.
+	bool addPanel(const int& x0, const int& y0, const int& x1, const int& y1, const bool& raised);
+
+	// Add a solid rectangle
+	bool addRectangle(const int& x0, const int& y0, const int& x1, const int& y1, const float& red, const float& green, const float& blue);
+
+	void draw();
+
+private:
+	static const int nMaxPanels = 8;
+
+	int nScreenWidth;
+
+	int nScreenHeight;
+
+	unsigned int nProgram;
+
+	unsigned int nVertexArray;
+
+	std::vector<int> panelRects; // Four corners per panel
+
+	std::vector<int> panelStyles;
+
+	std::vector<float> panelColors; // Three components per panel (solid rectangles only)
+
+	bool addPanel(const int& x0, const int& y0, const int& x1, const int& y1, const int& style, const float& red, const float& green, const float& blue);
+};
+
+#endif // ifndef Background_HPP
@@ -0,0 +1,150 @@
+#ifndef BitPlane_HPP
+#define BitPlane_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Packed 2d array of bits (one bit per cell, each row aligned to a 64-bit word).
+// Every row is padded by one zero word on either side and the plane is padded
+// by one zero row above and below, so that neighbor kernels never need bounds checks.
+class BitPlane {
+public:
+	BitPlane();
+
+	BitPlane(const int& width, const int& height);
+
+	int getWidth() const {
+		return nWidth;
+	}
+
+	int getHeight() const {
+		return nHeight;
+	}
+
+	// Number of 64-bit words of cell data in each row (not including padding)
+	int getRowWords() const {
+		return nWords;
+	}
+
+	// Distance (in words) between the starts of two consecutive rows
+	int getStride() const {
+		return nStride;
+	}
+
+	bool get(const int& x, const int& y) const {
+		return ((data[offset(x, y)] >> (x & 63)) & 1) != 0;
+	}
+
+	bool get(const int& index) const {
+		return get(index % nWidth, index / nWidth);
+	}
+
+	void set(const int& x, const int& y) {
+		data[offset(x, y)] |= (1ULL << (x & 63));
+	}
+
+	void set(const int& index) {
+		set(index % nWidth, index / nWidth);
+	}
+
+	void reset(const int& x, const int& y) {
+		data[offset(x, y)] &= ~(1ULL << (x & 63));
+	}
+
+	void reset(const int& index) {
+		reset(index % nWidth, index / nWidth);
+	}
+
+	// Pointer to the first data word of row y (rows -1 and nHeight are valid zero padding rows)
+	const uint64_t* getRow(const int& y) const {
+		return &data[(y + 1) * nStride + 1];
+	}
+
+	uint64_t* getRow(const int& y) {
+		return &data[(y + 1) * nStride + 1];
+	}
+
+	void resize(const int& width, const int& height);
+
+	// Set all bits to zero
+	void clear();
+
+	// Set all bits inside the plane to one
+	void fill();
+
+	// Get the total number of set bits
+	int count() const ;
+
+	// Copy the cell data (without padding) to or from nHeight * nWords words
+	void copyTo(uint64_t* words) const ;
+
+	void copyFrom(const uint64_t* words);
+
+	// Write the number of set neighbors (0-8) of every cell to one byte per cell (row-major, no padding).
+	// Cells whose own bit is set are assigned setValue instead.
+	void countNeighbors(std::vector<unsigned char>& counts, const unsigned char& setValue) const ;
+
+	// Get the name of the neighbor counting kernel selected for this cpu
+	static std::string getKernelName();
+
+	// Get the number of set bits in a word
+	static int countBits(const uint64_t& word) {
+#if defined(__GNUC__)
+		return __builtin_popcountll(word);
+#else
+		int total = 0;
+		uint64_t val = word;
+		while (val) {
+			val &= val - 1;
+			total++;
+		}
+		return total;
+#endif
+	}
+
+	// Get the index of the lowest set bit of a non-zero word
+	static int lowestBit(const uint64_t& word) {
+#if defined(__GNUC__)
+		return __builtin_ctzll(word);
+#else
+		int bit = 0;
+		uint64_t val = word;
+		while ((val & 1) == 0) {
+			val >>= 1;
+			bit++;
+		}
+		return bit;
+#endif
+	}
+
+	// Get the index of the highest set bit of a non-zero word
+	static int highestBit(const uint64_t& word) {
+#if defined(__GNUC__)
+		return 63 - __builtin_clzll(word);
+#else
+		int bit = 63;
+		while (((word >> bit) & 1) == 0) {
+			bit--;
+		}
+		return bit;
+#endif
+	}
+
+private:
+	int nWidth;
+
+	int nHeight;
+
+	int nWords;
+
+	int nStride;
+
+	std::vector<uint64_t> data;
+
+	int offset(const int& x, const int& y) const {
+		return (y + 1) * nStride + 1 + (x >> 6);
+	}
+};
+
+#endif // ifndef BitPlane_HPP
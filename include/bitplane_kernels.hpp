@@ -0,0 +1,82 @@
+#ifndef BitPlaneKernels_HPP
+#define BitPlaneKernels_HPP
+
+#include <cstdint>
+
+// Shift-and-add neighbor counting kernels shared by the scalar and SIMD implementations.
+// Everything here has internal linkage so that each translation unit (which may be compiled
+// with a different instruction set) gets its own copy.
+
+namespace {
+
+// Scalar (64 cells per step) operations
+struct ScalarOps {
+	typedef uint64_t Type;
+
+	static const int nLanes = 1;
+
+	static Type load(const uint64_t* ptr) { return *ptr; }
+
+	static void store(uint64_t* ptr, const Type& val) { *ptr = val; }
+
+	static Type bitAnd(const Type& a, const Type& b) { return a & b; }
+
+	static Type bitOr(const Type& a, const Type& b) { return a | b; }
+
+	static Type bitXor(const Type& a, const Type& b) { return a ^ b; }
+
+	static Type shiftLeft1(const Type& a) { return a << 1; }
+
+	static Type shiftLeft63(const Type& a) { return a << 63; }
+
+	static Type shiftRight1(const Type& a) { return a >> 1; }
+
+	static Type shiftRight63(const Type& a) { return a >> 63; }
+};
+
+// Compute the 4-bit neighbor count planes (b0 is the least significant bit) for words [begin, end) of one row.
+// Loads one word before and after each block, so the rows must be padded on both sides.
+template <class Ops>
+void countNeighborWords(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* b0, uint64_t* b1, uint64_t* b2, uint64_t* b3, const int& begin, const int& end) {
+	typedef typename Ops::Type T;
+	for (int w = begin; w + Ops::nLanes <= end; w += Ops::nLanes) {
+		// Cell x receives the bit of cell x-1 (west) from a left shift and cell x+1 (east) from a right shift
+		const T u = Ops::load(up + w);
+		const T uw = Ops::bitOr(Ops::shiftLeft1(u), Ops::shiftRight63(Ops::load(up + w - 1)));
+		const T ue = Ops::bitOr(Ops::shiftRight1(u), Ops::shiftLeft63(Ops::load(up + w + 1)));
+		const T m = Ops::load(mid + w);
+		const T mw = Ops::bitOr(Ops::shiftLeft1(m), Ops::shiftRight63(Ops::load(mid + w - 1)));
+		const T me = Ops::bitOr(Ops::shiftRight1(m), Ops::shiftLeft63(Ops::load(mid + w + 1)));
+		const T d = Ops::load(down + w);
+		const T dw = Ops::bitOr(Ops::shiftLeft1(d), Ops::shiftRight63(Ops::load(down + w - 1)));
+		const T de = Ops::bitOr(Ops::shiftRight1(d), Ops::shiftLeft63(Ops::load(down + w + 1)));
+
+		// Full adders over each row (total = s + 2c)
+		const T s1 = Ops::bitXor(Ops::bitXor(uw, u), ue);
+		const T c1 = Ops::bitOr(Ops::bitAnd(uw, u), Ops::bitAnd(ue, Ops::bitXor(uw, u)));
+		const T s2 = Ops::bitXor(Ops::bitXor(dw, d), de);
+		const T c2 = Ops::bitOr(Ops::bitAnd(dw, d), Ops::bitAnd(de, Ops::bitXor(dw, d)));
+		const T s3 = Ops::bitXor(mw, me);
+		const T c3 = Ops::bitAnd(mw, me);
+
+		// Ones column
+		const T ones = Ops::bitXor(Ops::bitXor(s1, s2), s3);
+		const T k1 = Ops::bitOr(Ops::bitAnd(s1, s2), Ops::bitAnd(s3, Ops::bitXor(s1, s2)));
+
+		// Twos column (c1 + c2 + c3 + k1)
+		const T t0 = Ops::bitXor(Ops::bitXor(c1, c2), c3);
+		const T t1 = Ops::bitOr(Ops::bitAnd(c1, c2), Ops::bitAnd(c3, Ops::bitXor(c1, c2)));
+		const T twos = Ops::bitXor(t0, k1);
+		const T k2 = Ops::bitAnd(t0, k1);
+
+		// Fours and eights columns (t1 + k2)
+		Ops::store(b0 + w, ones);
+		Ops::store(b1 + w, twos);
+		Ops::store(b2 + w, Ops::bitXor(t1, k2));
+		Ops::store(b3 + w, Ops::bitAnd(t1, k2));
+	}
+}
+
+} // namespace
+
+#endif // ifndef BitPlaneKernels_HPP
@@ -0,0 +1,141 @@
+#ifndef EndlessField_HPP
+#define EndlessField_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+#include "minefield.hpp"
+
+// Unbounded minefield split into fixed size chunks which are only allocated once one of their
+// cells is revealed or flagged. Mines are never stored; whether or not a cell contains a mine is
+// derived from a seeded hash of its coordinates, so untouched regions cost no memory.
+class EndlessField {
+public:
+	// Chunks are 64 x 64 cells (one 64-bit word per row)
+	static const int nChunkBits = 6;
+
+	static const int nChunkSize = 1 << nChunkBits;
+
+	EndlessField();
+
+	EndlessField(const double& density);
+
+	GameStates getState() const {
+		return gameState;
+	}
+
+	// Number of cells revealed so far
+	long long getRevealedCells() const {
+		return nRevealedCells;
+	}
+
+	size_t getChunkCount() const {
+		return chunks.size();
+	}
+
+	// Approximate memory used by allocated chunks (in bytes)
+	size_t getMemoryUsage() const {
+		return chunks.size() * (sizeof(Chunk) + sizeof(uint64_t) + 2 * sizeof(void*));
+	}
+
+	// Incremented every time a cell changes state
+	unsigned long long getRevision() const {
+		return nRevision;
+	}
+
+	double getDensity() const {
+		return dDensity;
+	}
+
+	uint64_t getSeed() const {
+		return nSeed;
+	}
+
+	// Return true if a zero cascade was cut short and must be continued with continueCascade()
+	bool isCascading() const {
+		return !workStack.empty();
+	}
+
+	void setDensity(const double& density);
+
+	void setSeed(const uint64_t& seed);
+
+	// Set a random seed
+	void seed();
+
+	// Maximum number of cells revealed by a single cascade step
+	void setMaxCascade(const size_t& cells) {
+		nMaxCascade = cells;
+	}
+
+	void resetField();
+
+	bool isMine(const int64_t& x, const int64_t& y) const ;
+
+	// Get the number of mines surrounding a cell
+	unsigned char getNumber(const int64_t& x, const int64_t& y) const ;
+
+	// Get the tile value of a cell (0-8 neighboring mines, or a TileTypes value such as BOMB)
+	unsigned char getCell(const int64_t& x, const int64_t& y) const ;
+
+	// Get the cover state of a cell (0: uncovered, 1: covered, 2: flagged, 3: unknown)
+	unsigned char getCover(const int64_t& x, const int64_t& y) const ;
+
+	void uncoverCell(const int64_t& x, const int64_t& y);
+
+	bool chordCell(const int64_t& x, const int64_t& y);
+
+	void cycleFlag(const int64_t& x, const int64_t& y);
+
+	// Continue revealing a zero cascade which exceeded the maximum cascade size
+	void continueCascade();
+
+private:
+	struct Chunk {
+		uint64_t revealed[nChunkSize];
+
+		uint64_t flagged[nChunkSize];
+
+		uint64_t unknown[nChunkSize];
+	};
+
+	bool bFirstCell;
+
+	GameStates gameState;
+
+	double dDensity;
+
+	uint64_t nThreshold;
+
+	uint64_t nSeed;
+
+	int64_t nSafeX;
+
+	int64_t nSafeY;
+
+	int64_t nExplosionX;
+
+	int64_t nExplosionY;
+
+	long long nRevealedCells;
+
+	unsigned long long nRevision;
+
+	size_t nMaxCascade;
+
+	std::unordered_map<uint64_t, Chunk> chunks;
+
+	std::vector<std::pair<int64_t, int64_t> > workStack;
+
+	static uint64_t getChunkKey(const int64_t& x, const int64_t& y);
+
+	const Chunk* findChunk(const int64_t& x, const int64_t& y) const ;
+
+	Chunk& getChunk(const int64_t& x, const int64_t& y);
+
+	bool reveal(const int64_t& x, const int64_t& y);
+};
+
+#endif // ifndef EndlessField_HPP
@@ -0,0 +1,161 @@
+#ifndef FrameTimer_HPP
+#define FrameTimer_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+enum class FramePhases {
+	INPUT,
+	LOGIC,
+	TILES,
+	RENDER
+};
+
+// Timing of one frame (in nanoseconds)
+struct FrameRecord {
+	static const int nPhases = 4;
+
+	static const int nMaxSpans = 16; // Later spans of a frame are only counted in the phase times
+
+	uint64_t nFrame;
+
+	uint64_t nStart; // Since the timer was created
+
+	uint64_t nDuration;
+
+	uint64_t nPhaseTime[nPhases]; // Total time spent in each phase
+
+	uint64_t nInputLatency; // Time from a click until the end of the frame which showed its result (zero if none)
+
+	uint64_t nSpans; // Number of spans stored
+
+	int nSpanPhase[nMaxSpans]; // Phase of each span of time spent in one phase without leaving it
+
+	uint64_t nSpanStart[nMaxSpans]; // Since the start of the frame
+
+	uint64_t nSpanTime[nMaxSpans];
+};
+
+struct PhaseStatistics {
+	size_t nFrames;
+
+	double dMean; // In milliseconds
+
+	double dMedian;
+
+	double dPercentile99;
+
+	double dMax;
+};
+
+// Measures the time spent in each phase of every frame. Time is only counted towards the innermost phase,
+// so a phase started inside another pauses the outer one, and each span of time spent in one phase is kept.
+// Finished frames are written to a fixed size ring buffer of recent frames which may be read from any thread
+// without blocking the frame loop.
+class FrameTimer {
+public:
+	FrameTimer(const size_t& capacity = 1024);
+
+	// Number of frames finished since the timer was created
+	uint64_t getFrameCount() const {
+		return nWritten.load(std::memory_order_acquire);
+	}
+
+	size_t getCapacity() const {
+		return nCapacity;
+	}
+
+	static std::string getPhaseName(const FramePhases& phase);
+
+	void beginFrame();
+
+	void endFrame();
+
+	// Set the input latency of the current frame (time since the input was sampled, in nanoseconds)
+	void setInputLatency(const uint64_t& latency) {
+		current.nInputLatency = latency;
+	}
+
+	// Start counting time towards a phase, return the phase which was active (-1 if none)
+	int enterPhase(const int& phase);
+
+	int enterPhase(const FramePhases& phase) {
+		return enterPhase((int)phase);
+	}
+
+	// Copy the frames currently in the ring buffer (oldest first)
+	void getFrames(std::vector<FrameRecord>& frames) const ;
+
+	// Get statistics of a phase (or of the whole frame, for phase < 0) over the frames in the ring buffer
+	static PhaseStatistics getStatistics(const std::vector<FrameRecord>& frames, const int& phase);
+
+	// Get statistics of the input latency of the frames in the ring buffer which showed the result of a click
+	static PhaseStatistics getLatencyStatistics(const std::vector<FrameRecord>& frames);
+
+	// Print per phase statistics of recent frames
+	void print() const ;
+
+	// Write recent frames to a file, as Chrome trace JSON if the file name ends with ".json" and as CSV otherwise
+	bool write(const std::string& fname) const ;
+
+private:
+	// Values of a frame record stored in a ring buffer slot (the phase of a span is packed with its start)
+	static const int nRecordValues = 5 + FrameRecord::nPhases + 2 * FrameRecord::nMaxSpans;
+
+	struct Slot {
+		std::atomic<uint64_t> nSequence; // Odd while the slot is being written
+
+		std::atomic<uint64_t> nValues[nRecordValues];
+	};
+
+	size_t nCapacity;
+
+	std::atomic<uint64_t> nWritten;
+
+	int nCurrentPhase;
+
+	std::chrono::steady_clock::time_point startTime;
+
+	std::chrono::steady_clock::time_point frameStart;
+
+	std::chrono::steady_clock::time_point phaseStart;
+
+	FrameRecord current;
+
+	std::unique_ptr<Slot[]> slots;
+
+	// Get statistics of a list of times (sorts the list)
+	static PhaseStatistics getStatistics(std::vector<uint64_t>& times);
+
+	uint64_t getElapsed(const std::chrono::steady_clock::time_point& since, const std::chrono::steady_clock::time_point& now) const ;
+
+	bool writeCsv(const std::string& fname, const std::vector<FrameRecord>& frames) const ;
+
+	bool writeTrace(const std::string& fname, const std::vector<FrameRecord>& frames) const ;
+};
+
+// Count the time until the end of the current scope towards a phase
+class ScopedPhaseTimer {
+public:
+	ScopedPhaseTimer(FrameTimer& timer, const FramePhases& phase) :
+		parent(timer),
+		nPreviousPhase(timer.enterPhase((int)phase))
+	{
+	}
+
+	~ScopedPhaseTimer() {
+		parent.enterPhase(nPreviousPhase);
+	}
+
+private:
+	FrameTimer& parent;
+
+	int nPreviousPhase;
+};
+
+#endif // ifndef FrameTimer_HPP
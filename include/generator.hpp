@@ -0,0 +1,149 @@
+#ifndef Generator_HPP
+#define Generator_HPP
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include "threadpool.hpp"
+
+class Minefield;
+class Solver;
+
+// Minefield size, mine count, and first cell region of a pre-generated board
+struct BoardKey {
+	int nWidth;
+
+	int nHeight;
+
+	int nMines;
+
+	int nRegion;
+
+	bool operator<(const BoardKey& rhs) const ;
+};
+
+// Generates mine layouts which can be solved from the first click without guessing. The minefield is
+// divided into small regions; every cell of the first clicked region (and its neighbors) is kept free
+// of mines so that clicking anywhere in the region opens the same area, and the board is accepted only
+// if the deterministic solver can clear it from there. Boards are generated on worker threads and kept
+// in a pool for each region so that the first click does not have to wait. Every board has its own
+// random stream, numbered by region and by the order boards are handed out, so the boards returned
+// for a seed are the same no matter how many threads fill the pool.
+class BoardGenerator {
+public:
+	// Regions are 3 x 3 cells
+	static const int nRegionSize = 3;
+
+	BoardGenerator(const unsigned int& nThreads = 0);
+
+	~BoardGenerator();
+
+	// Set the seed of every board (the pool is emptied and refilled)
+	void setSeed(const uint64_t& seed);
+
+	// Number of boards kept ready for each region
+	void setPoolSize(const size_t& boards) {
+		nPoolSize = boards;
+	}
+
+	// Maximum number of random layouts tried when generating a board on the calling thread
+	void setMaxAttempts(const unsigned long long& attempts) {
+		nMaxAttempts = attempts;
+	}
+
+	// Number of accepted boards
+	unsigned long long getBoardsGenerated() const {
+		return nBoardsGenerated;
+	}
+
+	// Number of random layouts tried
+	unsigned long long getAttempts() const {
+		return nAttempts;
+	}
+
+	// Total time spent generating boards on all threads (in seconds)
+	double getGenerationTime() const ;
+
+	size_t getThreadCount() const {
+		return (pool ? pool->getThreadCount() : 0);
+	}
+
+	// Get the region containing a cell
+	static int getRegion(const int& width, const int& cell);
+
+	// Get the cell in the middle of a region
+	static int getRegionCenter(const int& width, const int& height, const int& region);
+
+	// Start filling the pool for every region of a minefield size in the background
+	void prepare(const int& width, const int& height, const int& mines);
+
+	// Stop generating boards in the background
+	void stop();
+
+	// Get a board which is solvable without guessing when first clicking a cell. A board is taken from
+	// the pool if one is ready, otherwise one is generated on the calling thread.
+	bool getBoard(const int& width, const int& height, const int& mines, const int& cell, std::vector<int>& layout);
+
+	// Generate a single board on the calling thread, return false if no solvable board was found
+	bool generate(const BoardKey& key, const uint64_t& seed, std::vector<int>& layout, const unsigned long long& maxAttempts);
+
+private:
+	// Boards of one region, numbered in the order they are handed out
+	struct RegionPool {
+		unsigned long long nNext; // Next board to hand out
+
+		unsigned long long nQueued; // Next board to generate in the background
+
+		std::map<unsigned long long, std::vector<int> > boards; // Finished boards waiting to be handed out
+	};
+
+	std::atomic<bool> bStop;
+
+	std::atomic<bool> bActive; // Set while background tasks are refilling the pool
+
+	std::atomic<bool> bFailed; // Set if no solvable board could be found for the current size
+
+	size_t nPoolSize;
+
+	unsigned long long nMaxAttempts;
+
+	std::atomic<unsigned long long> nBoardsGenerated;
+
+	std::atomic<unsigned long long> nAttempts;
+
+	std::atomic<unsigned long long> nGenerationTime; // In microseconds
+
+	int nWidth; // Size of the minefield being refilled
+
+	int nHeight;
+
+	int nMines;
+
+	unsigned int nThreads;
+
+	std::mutex lock;
+
+	uint64_t nSeed;
+
+	std::unique_ptr<ThreadPool> pool; // Created when the first pool is prepared
+
+	std::map<BoardKey, RegionPool> pools;
+
+	// Get the seed of the random stream of a board
+	uint64_t getBoardSeed(const BoardKey& key, const unsigned long long& board) const ;
+
+	// Find a region whose pool is not full, return false if all are full. If board is set, the next
+	// board of the region is reserved for the caller to generate.
+	bool findEmptyRegion(BoardKey& key, unsigned long long* board = 0x0);
+
+	// Generate boards until every region of the pool is full
+	void refill();
+
+	void startRefill();
+};
+
+#endif // ifndef Generator_HPP
@@ -0,0 +1,383 @@
+#ifndef Minefield_HPP
+#define Minefield_HPP
+
+#include <vector>
+#include <map>
+#include <cstdint>
+
+#include "bitplane.hpp"
+#include "splitmix.hpp"
+#include "topology.hpp"
+
+enum class TileTypes {
+	NONE,
+	ZERO,
+	ONE,
+	TWO,
+	THREE,
+	FOUR,
+	FIVE,
+	SIX,
+	SEVEN,
+	EIGHT,
+	NORMAL,
+	FLAGGED,
+	UNKNOWN,
+	BOMB,
+	EXPLOSION,
+	MISTAKE
+};
+
+enum class GameStates {
+	NORMAL,
+	PAUSED,
+	WIN,
+	LOSS
+};
+
+// Headless minesweeper board engine (no window or graphics dependencies)
+class Minefield {
+public:
+	Minefield();
+
+	Minefield(const int& width, const int& height, const int& bombs);
+
+	// Get the board size and mine count for one of the built-in difficulty levels
+	static bool getDifficulty(const unsigned int& level, int& width, int& height, int& bombs);
+
+	// Get the tile value (sprite index) used for a tile type
+	static unsigned char getDefaultTileValue(const TileTypes& type);
+
+	int getWidth() const {
+		return nSizeX;
+	}
+
+	int getHeight() const {
+		return nSizeY;
+	}
+
+	int getCells() const {
+		return nSizeX * nSizeY;
+	}
+
+	int getBombs() const {
+		return nBombs;
+	}
+
+	int getRemainingCells() const {
+		return nRemainingCells;
+	}
+
+	GameStates getState() const {
+		return gameState;
+	}
+
+	bool isFirstCell() const {
+		return bFirstCell;
+	}
+
+	Topologies getTopology() const {
+		return topology;
+	}
+
+	const TopologyGrid& getTopologyGrid() const {
+		return grid;
+	}
+
+	// Get the tile value of a cell (0-8 neighboring mines, or a TileTypes value such as BOMB)
+	unsigned char getCell(const int& index) const {
+		return minefield[index];
+	}
+
+	// Get the cover state of a cell (0: uncovered, 1: covered, 2: flagged, 3: unknown)
+	unsigned char getCover(const int& x, const int& y) const {
+		if (!covered.get(x, y))
+			return 0;
+		if (flagged.get(x, y))
+			return 2;
+		return (unknown.get(x, y) ? 3 : 1);
+	}
+
+	unsigned char getCover(const int& index) const {
+		return getCover(index % nSizeX, index / nSizeX);
+	}
+
+	bool isBomb(const int& x, const int& y) const {
+		return mines.get(x, y);
+	}
+
+	const BitPlane& getMinePlane() const {
+		return mines;
+	}
+
+	const BitPlane& getCoveredPlane() const {
+		return covered;
+	}
+
+	const BitPlane& getFlaggedPlane() const {
+		return flagged;
+	}
+
+	// Cells whose tile value or cover state changed since the last call to clearChanges()
+	const std::vector<int>& getChangedCells() const {
+		return changedCells;
+	}
+
+	// Return true if too many cells changed to list them individually (or the field was reset)
+	bool isFullUpdate() const {
+		return bFullUpdate;
+	}
+
+	void clearChanges();
+
+	// Number of 64-bit words in one bit-plane (each row padded to whole words)
+	size_t getPlaneWords() const {
+		return (size_t)nSizeY * covered.getRowWords();
+	}
+
+	// Number of 64-bit words needed to save the cover state of every cell
+	size_t getStateWords() const {
+		return 3 * getPlaneWords();
+	}
+
+	// Save the position of every mine (getPlaneWords() words)
+	void saveMines(uint64_t* words) const ;
+
+	// Restore saved mine positions before the first cell is uncovered.
+	// Return false if the number of mines is wrong or bits past the end of a row are set.
+	bool loadMines(const uint64_t* words);
+
+	// Save the cover state of every cell (covered, flagged, and unknown cells)
+	void saveState(uint64_t* words) const ;
+
+	// Restore a saved cover state of an unfinished game. The mines must already be placed.
+	bool loadState(const uint64_t* words);
+
+	unsigned char getTileValue(const TileTypes& type) const ;
+
+	void setSize(const int& width, const int& height, const int& bombs);
+
+	// Set which cells are neighbors (layerRows is the number of rows in each layer of a cubic minefield).
+	// Return false, and keep the current topology, if the minefield is too small or not a whole number of layers.
+	bool setTopology(const Topologies& type, const int& layerRows = 0);
+
+	// Set the seed of the mine layouts. Each board placed by placeBombs() uses its own stream of the seed,
+	// so the n-th board after setting a seed is always the same.
+	void setSeed(const uint64_t& seed);
+
+	// Set a random seed
+	void seed();
+
+	uint64_t getSeed() const {
+		return nSeed;
+	}
+
+	void resetField();
+
+	// Randomly place mines in every cell except one (done automatically when the first cell is uncovered)
+	void placeBombs(const int& safeCell);
+
+	// Use a pre-generated mine layout instead of placing mines randomly on the first click.
+	// Return false if the first cell was already uncovered or the number of mines is wrong.
+	bool setMines(const std::vector<int>& cells);
+
+	TileTypes getTileType(const int& x, const int& y) const ;
+
+	TileTypes getTileType(const int& index) const ;
+
+	// Get a cell and its neighbors
+	void getNeighbors(std::vector<int>& vec, const int& x, const int& y) const ;
+
+	// Get the cells of a type out of a cell and its neighbors, return false if there are none
+	bool getNeighbors(std::vector<int>& vec, const TileTypes& type, const int& x, const int& y) const ;
+
+	void uncoverCell(const int& x, const int& y);
+
+	void uncoverCell(const int& cell);
+
+	bool chordCell(const int& x, const int& y);
+
+	void cycleFlag(const int& cell);
+
+	// Keep a history of moves which can be undone (off by default, since every move has to record its changes)
+	void setHistoryEnabled(const bool& enabled);
+
+	bool canUndo() const {
+		return (nHistoryPosition > 0);
+	}
+
+	bool canRedo() const {
+		return (nHistoryPosition < moveHistory.size());
+	}
+
+	// Memory used by the move history (in bytes)
+	size_t getHistorySize() const ;
+
+	// Undo the last move (including a move which ended the game), return false if there is none
+	bool undo();
+
+	// Redo the last undone move, return false if there is none
+	bool redo();
+
+private:
+	// Change made by one move. The cover plane words it changed are stored XOR their previous values (as are
+	// the tile values it changed), so applying the same change again undoes or redoes the move.
+	struct MoveDelta {
+		size_t nFirstWord; // Offset into historyWords
+
+		size_t nFirstTile; // Offset into historyTiles
+
+		int nRemainingBefore;
+
+		int nRemainingAfter;
+
+		GameStates stateBefore;
+
+		GameStates stateAfter;
+	};
+
+	struct TileDelta {
+		int nCell;
+
+		unsigned char nValue;
+	};
+
+	uint64_t nSeed;
+
+	uint64_t nBoards; // Boards placed since the seed was set
+
+	bool bFirstCell;
+
+	bool bFullUpdate;
+
+	int nSizeX;
+
+	int nSizeY;
+
+	int nBombs;
+
+	int nRemainingCells;
+
+	int nMaxChanges;
+
+	GameStates gameState;
+
+	Topologies topology;
+
+	TopologyGrid grid;
+
+	std::vector<unsigned char> minefield;
+
+	BitPlane mines;
+
+	BitPlane covered;
+
+	BitPlane flagged;
+
+	BitPlane unknown;
+
+	BitPlane blank; // Cells with no neighboring mines (not including mines)
+
+	std::vector<int> chordNeighbors;
+
+	std::vector<int> changedCells;
+
+	// Part of a row next to an uncovered run of blank cells (dy is the direction away from the run)
+	struct FillSegment {
+		int y;
+
+		int x0;
+
+		int x1;
+
+		int dy;
+	};
+
+	std::vector<FillSegment> fillStack; // Segments waiting to be searched by fillArea()
+
+	std::vector<int> fillCells; // Blank cells waiting to be searched by fillArea() (for topologies other than square)
+
+	bool bHistory;
+
+	int nMoveDepth; // Moves currently being recorded (chords uncover cells, which are moves themselves)
+
+	size_t nHistoryPosition; // Moves before this one can be undone, the rest can be redone
+
+	std::vector<MoveDelta> moveHistory;
+
+	std::vector<uint32_t> historyWords; // Index of each changed word (in a cover plane)
+
+	std::vector<uint64_t> historyMasks; // Covered, flagged, and unknown plane changes of each changed word
+
+	std::vector<TileDelta> historyTiles;
+
+	std::vector<unsigned char> touchedWords; // Words already saved by the move being recorded
+
+	std::map<TileTypes, unsigned char> gridMap;
+
+	TileTypes typeMap[256];
+
+	void setTileType(const int& x, const int& y, const TileTypes& type);
+
+	void setTileType(const int& index, const TileTypes& type);
+
+	void countNumbers();
+
+	template <class Topology>
+	void countNumbers();
+
+	// Add one to every neighbor of each mine
+	template <class Topology>
+	void scatterNumbers();
+
+	// Mark every cell with no neighboring mines in the blank plane
+	template <class Topology>
+	void findBlankCells();
+
+	template <class Topology>
+	void getNeighbors(std::vector<int>& vec, const int& x, const int& y) const ;
+
+	void endGame(bool bWin);
+
+	// Uncover a blank cell and every cell connected to it by blank cells. Only the fill neighbors of each blank
+	// cell are uncovered (see topology.hpp), so square and torus cascades spread in four directions and stop
+	// short of the diagonal cells, while every neighbor of a blank hex or cubic cell is uncovered.
+	template <class Topology>
+	void fillArea(const int& startX, const int& startY);
+
+	void fillArea(const int& index);
+
+	void uncover(const int& x, const int& y);
+
+	// Uncover the cells from x0 to x1 (inclusive) of a row, return the number which were covered
+	int uncoverRun(const int& y, const int& x0, const int& x1, const bool& bSkipBlank = false);
+
+	// Uncover the run of blank cells containing a cell (and the numbered cells at either end), queue the rows above
+	// and below it, and set x1 to the end of the run. The parent segment is the one the run was found in (dy is
+	// zero for the first run of a cascade).
+	int uncoverBlankRun(const int& x, const int& y, const FillSegment& parent, int& x1);
+
+	void markChanged(const int& cell);
+
+	void decrement();
+
+	// Reserve the history of a game for the current minefield size
+	void allocateHistory();
+
+	void clearHistory();
+
+	void beginMove();
+
+	void endMove();
+
+	// Save a word of the cover planes before the move being recorded changes it
+	void saveWord(const int& y, const int& w);
+
+	// Save the change of a tile value made by the move being recorded
+	void saveTile(const int& cell, const unsigned char& value);
+
+	// Apply the changes of a move to undo or redo it
+	void applyMove(const size_t& index, const bool& bUndo);
+};
+
+#endif // ifndef Minefield_HPP
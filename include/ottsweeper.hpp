@@ -3,71 +3,153 @@
 
 #include <vector>
 #include <string>
-#include <map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
 
 #include "OTTApplication.hpp"
-#include "OTTSpriteSet.hpp"
-#include "OTTRandom.hpp"
 #include "ColorRGB.hpp"
 
-enum class TileTypes {
-	NONE,
-	ZERO,
-	ONE,
-	TWO,
-	THREE,
-	FOUR,
-	FIVE,
-	SIX,
-	SEVEN,
-	EIGHT,
-	NORMAL,
-	FLAGGED,
-	UNKNOWN,
-	BOMB,
-	EXPLOSION,
-	MISTAKE
+#include "minefield.hpp"
+#include "endlessfield.hpp"
+#include "tileview.hpp"
+#include "solver.hpp"
+#include "probability.hpp"
+#include "generator.hpp"
+#include "replay.hpp"
+#include "snapshot.hpp"
+#include "frametimer.hpp"
+#include "tilebatch.hpp"
+#include "background.hpp"
+#include "spscqueue.hpp"
+
+enum class InputEvents {
+	HOVER, // Buttons held over a cell
+	LEFT_RELEASE,
+	RIGHT_RELEASE,
+	RESET,
+	HINT,
+	PROBABILITIES,
+	UNDO,
+	REDO
 };
 
-enum class GameStates {
-	NORMAL,
-	PAUSED,
-	WIN,
-	LOSS
+// Input sampled by the frame loop and applied by the game logic
+struct InputEvent {
+	InputEvents type;
+
+	int cell; // Cell under the mouse (-1 if none)
+
+	bool bLeftHeld;
+
+	bool bRightHeld;
+
+	double dGameTime; // Game timer when the input was sampled (in seconds)
+
+	uint64_t nTimestamp; // Steady clock time when the input was sampled (in nanoseconds)
+};
+
+// Tile changed by the game logic
+struct TileUpdate {
+	int cell;
+
+	unsigned char tile;
 };
 
 class Ottsweeper : public OTTApplication {
 public:
 	Ottsweeper() :
 		OTTApplication(160, 186),
-		rng(OTTRandom::Generator::XORSHIFT),
-		bFirstCell(true),
 		bLeftClickHeld(false),
-		nSizeX(10),
-		nSizeY(10),
-		nBombs(10),
-		nRemainingCells(nSizeX* nSizeY - nBombs),
+		bEndless(false),
+		bNoGuess(false),
+		bReplaying(false),
+		bUnrecordedGame(false),
+		bOnDemand(false),
+		bRedrawRequested(true),
+		bInputThread(false),
+		bStopLogic(false),
+		bHoverLeft(false),
+		bHoverRight(false),
 		nMinefieldOffsetX(12),
 		nMinefieldOffsetY(54),
 		nCurrentCellX(0),
 		nCurrentCellY(0),
 		nCurrentCell(0),
+		nViewX(0),
+		nViewY(0),
+		nDrawnRevision(~0ULL),
+		nDrawnViewX(0),
+		nDrawnViewY(0),
+		nDrawnPressedCell(-1),
+		nViewColumns(0),
+		nViewRows(0),
+		nCameraX(0),
+		nCameraY(0),
+		nZoom(0),
+		nMinZoom(0),
+		nRowShift(0),
+		nFirstColumn(0),
+		nFirstRow(0),
+		nGridColumns(0),
+		nGridRows(0),
+		nHoverCell(-1),
+		nPressedCell(-1),
+		nRemainingShown(0),
+		nLastClick(0),
+		nAppliedClick(0),
+		nPresentedClick(0),
+		dGameTime(0),
 		dFinalGameTime(0),
+		bResumeTimer(false),
 		dWindowScaleX(1),
 		dWindowScaleY(1),
-		nBackgroundContext(0),
-		digits(),
-		tiles(),
-		smilies(),
+		nFirstDigitSprite(0),
+		nFirstFaceSprite(0),
+		dAtlasLoadTime(0),
+		nSeed(0),
+		nEndlessBoards(0),
+		topology(Topologies::SQUARE),
+		nLayerRows(0),
 		gameState(GameStates::NORMAL),
-		minefield(),
-		playfield(),
-		gridMap()
+		drawnState(GameStates::NORMAL),
+		field(),
+		endless(),
+		solver(),
+		probabilities(),
+		generator(),
+		previewCells(),
+		drawnPreviewCells(),
+		boardLayout(),
+		windowTitle(),
+		shownTiles(),
+		recorder(),
+		player(),
+		recordFile(),
+		snapshotFile(),
+		timingFile(),
+		frameTimer(),
+		view(),
+		batch(),
+		background(),
+		lastHover(),
+		inputQueue(),
+		tileQueue(),
+		logicLock(),
+		logicWake(),
+		logicThread()
 	{
+		lastHover.cell = -1;
 	}
 
 	~Ottsweeper() override {
-		// Nothing to clean up, window will be closed by OTTWindow class
+		stopLogicThread();
+		saveSnapshot();
+		// Window will be closed by OTTWindow class
+		if (!timingFile.empty())
+			frameTimer.write(timingFile);
 	}
 
 	void setCurrentWindowScale(const double& x, const double& y) {
@@ -75,13 +157,39 @@ public:
 		dWindowScaleY = y;
 	}
 
+	// Draw the next frame even if nothing changed (e.g. after the window is resized)
+	void requestRedraw() {
+		bRedrawRequested = true;
+	}
+
 protected:
 	void rollDice();
 
+	// Update the solver with the cells changed since the last frame
 	void computeScores();
 
+	// Compute the exact mine probability of every covered cell
 	void computeProbabilities();
 
+	// Sample the mouse over the minefield and the smiley
+	void sampleInput(const bool& bInField);
+
+	// Record a move to the replay log (if enabled)
+	void recordMove(const ReplayEvents& type, const int& cell);
+
+	// Save the replay log of the current game (if enabled)
+	void saveRecording();
+
+	// Save the current game to the snapshot file if it is unfinished (or remove the snapshot file otherwise)
+	void saveSnapshot();
+
+	// Apply replayed moves up to the current game time
+	void updateReplay();
+
+	// Get the time to wait for input before the screen next needs to change (negative to wait indefinitely)
+	double getIdleTimeout() const ;
+
+	// Print the cells proven to be safe or mines by the solver
 	void printScores() const ;
 
 	void drawDie(const unsigned short& px, const unsigned short& py, const int& value);
@@ -93,19 +201,27 @@ protected:
 	bool onUserLoop() override;
 
 private:
-	OTTRandom rng;
+	bool bLeftClickHeld;
 
-	bool bFirstCell;
+	bool bEndless;
 
-	bool bLeftClickHeld;
+	bool bNoGuess; // Only play boards which can be solved without guessing
 
-	int nSizeX;
+	bool bReplaying; // Play back a replay log instead of taking input
 
-	int nSizeY;
+	bool bUnrecordedGame; // Current game was restored from a snapshot or had moves undone (and is not recorded)
 
-	int nBombs;
+	bool bOnDemand; // Only draw frames when something changed, and wait for input in between
 
-	int nRemainingCells;
+	bool bRedrawRequested;
+
+	bool bInputThread; // Run the game logic on its own thread, fed by input events from the frame loop
+
+	std::atomic<bool> bStopLogic;
+
+	bool bHoverLeft; // Mouse buttons held over nHoverCell (game logic state)
+
+	bool bHoverRight;
 
 	int nMinefieldOffsetX;
 
@@ -117,63 +233,167 @@ private:
 
 	int nCurrentCell;
 
-	double dFinalGameTime;
+	long long nViewX; // Endless minefield coordinates of the top left cell of the window
+
+	long long nViewY;
+
+	unsigned long long nDrawnRevision; // Endless minefield revision last drawn (the window is only redrawn when it changes)
+
+	long long nDrawnViewX;
+
+	long long nDrawnViewY;
+
+	int nDrawnPressedCell;
+
+	int nViewColumns; // Cells which fit in the window at 1x zoom
+
+	int nViewRows;
+
+	int nCameraX; // Minefield pixel (unscaled) at the top left corner of the window
+
+	int nCameraY;
+
+	int nZoom; // The minefield is scaled by 2^nZoom
+
+	int nMinZoom;
+
+	int nRowShift; // Odd rows are drawn shifted right by this many (unscaled) pixels
+
+	int nFirstColumn; // Top left cell drawn by the tile batch
+
+	int nFirstRow;
+
+	int nGridColumns; // Cells drawn by the tile batch
+
+	int nGridRows;
+
+	int nHoverCell; // Cell under the mouse while a button is held (-1 if none)
+
+	int nPressedCell; // Cell drawn pressed (-1 if none)
+
+	std::atomic<int> nRemainingShown; // Remaining cells counter, set by the game logic
+
+	uint64_t nLastClick; // Timestamp of the last click applied by the game logic
+
+	std::atomic<uint64_t> nAppliedClick; // Timestamp of the last click whose tiles have been published
+
+	uint64_t nPresentedClick; // Timestamp of the last click drawn by the frame loop
+
+	double dGameTime; // Game time of the input being applied (the logic thread can not read dTotalTime)
+
+	std::atomic<double> dFinalGameTime; // Game time when the game ended
+
+	std::atomic<bool> bResumeTimer; // Set by the game logic when the end of the game is undone
 
 	double dWindowScaleX;
 
 	double dWindowScaleY;
 
-	unsigned int nBackgroundContext;
+	int nFirstDigitSprite;
+
+	int nFirstFaceSprite;
+
+	double dAtlasLoadTime; // Time taken to load and upload the sprite atlas (in seconds)
+
+	uint64_t nSeed; // Every random stream of the game is derived from this seed
+
+	unsigned long long nEndlessBoards; // Endless minefields generated
+
+	Topologies topology;
+
+	int nLayerRows; // Rows in each layer of a cubic minefield
 
-	OTTSpriteSet digits;
+	std::atomic<GameStates> gameState;
 
-	OTTSpriteSet tiles;
+	GameStates drawnState; // Game state when the last frame was drawn (selects the smiley)
 
-	OTTSpriteSet smilies;
+	Minefield field;
 
-	GameStates gameState;
+	EndlessField endless;
 
-	std::vector<unsigned char> minefield;
+	Solver solver;
 
-	std::vector<unsigned char> playfield;
+	ProbabilityEngine probabilities;
 
-	std::map<TileTypes, unsigned char> gridMap;
+	BoardGenerator generator;
 
-	void setTileType(const int& x, const int& y, const TileTypes& type);
+	std::vector<int> previewCells; // Scratch buffers allocated at startup and reused every frame
 
-	void setTileType(const int& index, const TileTypes& type);
+	std::vector<int> drawnPreviewCells;
 
-	TileTypes getTileType(const int& x, const int& y) const ;
+	std::vector<int> boardLayout;
 
-	TileTypes getTileType(const int& index) const ;
+	std::string windowTitle;
 
-	void placeBombs(const int& safeCell);
+	std::vector<unsigned char> shownTiles; // Sprite of every cell, so that the camera can move without the game logic
+
+	ReplayWriter recorder;
+
+	ReplayPlayer player;
+
+	std::string recordFile;
+
+	std::string snapshotFile; // Unfinished games are saved here at exit (if set)
+
+	std::string timingFile; // Frame times are written here at exit (if set)
+
+	FrameTimer frameTimer;
+
+	TileView view;
+
+	TileBatch batch;
+
+	Background background;
+
+	InputEvent lastHover; // Last hover event sent by the frame loop
+
+	SpscQueue<InputEvent> inputQueue; // Frame loop to game logic
+
+	SpscQueue<TileUpdate> tileQueue; // Game logic to frame loop
+
+	std::mutex logicLock;
+
+	std::condition_variable logicWake;
+
+	std::thread logicThread;
 
 	void resetField();
 
 	void endGame(bool bWin);
 
-	void fillArea(const int& startX, const int& startY);
+	// Send an input event to the game logic (applied immediately unless the logic runs on its own thread)
+	void sendInput(const InputEvents& type, const int& cell);
+
+	void applyInput(const InputEvent& event);
+
+	// Check for the end of the game and update the solver and the pressed cells
+	void updateGame();
 
-	void fillArea(const int& index);
+	// Update the tile view and send the changed tiles to the tile batch
+	void updateTiles();
 
-	void getNeighbors(std::vector<int>& vec, const int& x, const int& y) const ;
+	void setTile(const int& cell, const unsigned char& tile);
 
-	bool getNeighbors(std::vector<int>& vec, const TileTypes& type, const int& x, const int& y) const ;
+	// Store a tile and draw it if it is in view (frame loop only)
+	void showTile(const int& cell, const unsigned char& tile);
 
-	void uncoverCell(const int& x, const int& y);
+	// Scroll the camera (in unscaled pixels) and change the zoom level, then refill the tile batch if the cells in view changed
+	void moveCamera(const int& dx, const int& dy, const int& zoom);
 
-	void uncoverCell(const int& cell);
+	// Get the number of cells the tile batch needs to cover the window at a zoom level
+	void getGridSize(const int& zoom, int& cols, int& rows) const ;
 
-	void decrement();
+	// Game logic thread
+	void logicLoop();
 
-	void drawNumber(const int& x, const int& y, const int& value);	
+	void stopLogicThread();
 
-	void drawTile(const int& x, const int& y, const TileTypes& type);
+	void handleEndlessInput();
 
-	void drawTile(const int& x, const int& y, const unsigned char& type);
+	void updateEndlessTiles();
 
-	void generateBackground();
+	// Add the window frame, header and minefield panels, and counter backgrounds
+	void layoutBackground();
 };
 
 #endif // ifndef Ottsweeper_HPP
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef Probability_HPP
+#define Probability_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "threadpool.hpp"
+
+class Minefield;
+class Solver;
+
+struct ComponentInfo {
+	int nCells; // Undetermined frontier cells
+
+	int nConstraints; // Revealed numbers bordering the cells
+
+	int nTasks; // Number of tasks the enumeration was split into
+
+	uint64_t nSolutions; // Number of consistent mine arrangements
+
+	double dCpuTime; // Total time spent enumerating (in seconds)
+
+	double dWallTime; // Time from the start of the first task to the end of the last (in seconds)
+};
+
+// Exact mine probabilities for every covered cell. The frontier is split into independent components,
+// every component is enumerated on a thread pool, and the results are combined with the number of
+// ways the remaining mines may be placed in the covered cells away from the frontier.
+class ProbabilityEngine {
+public:
+	ProbabilityEngine(const unsigned int& nThreads = 0);
+
+	// Get the mine probability of a cell (-1 for revealed cells)
+	double getProbability(const int& cell) const {
+		return probabilities[cell];
+	}
+
+	const std::vector<double>& getProbabilities() const {
+		return probabilities;
+	}
+
+	// Mine probability of covered cells which do not border a revealed number
+	double getOtherProbability() const {
+		return dOtherProbability;
+	}
+
+	const std::vector<ComponentInfo>& getComponents() const {
+		return components;
+	}
+
+	// Time taken by the last call to compute (in seconds)
+	double getTime() const {
+		return dTime;
+	}
+
+	size_t getThreadCount() const {
+		return pool.getThreadCount();
+	}
+
+	// Compute the probabilities for the current state of a minefield, using the frontier of an up to date
+	// solver. Return false if there is no arrangement of the remaining mines consistent with the board.
+	bool compute(const Minefield& field, const Solver& solver);
+
+	// Get the covered, unflagged cell with the lowest mine probability (or -1)
+	int getSafestCell(const Minefield& field) const ;
+
+private:
+	double dOtherProbability;
+
+	double dTime;
+
+	ThreadPool pool;
+
+	std::vector<double> probabilities;
+
+	std::vector<ComponentInfo> components;
+};
+
+#endif // ifndef Probability_HPP
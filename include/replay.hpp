@@ -0,0 +1,200 @@
+#ifndef Replay_HPP
+#define Replay_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+class Minefield;
+
+enum class ReplayEvents {
+	REVEAL,
+	FLAG,
+	CHORD
+};
+
+// Records every move of a game to a compact binary log. The log starts with the minefield size and
+// the (delta encoded) mine layout, followed by one varint record per move holding the move type, the
+// change in cell index, and the time since the previous move. A keyframe with the cover state of
+// every cell is inserted at a fixed interval so that a player can seek without replaying the game.
+class ReplayWriter {
+public:
+	ReplayWriter();
+
+	bool isRecording() const {
+		return bRecording;
+	}
+
+	size_t getEventCount() const {
+		return nEvents;
+	}
+
+	// Size of the log (in bytes)
+	size_t getSize() const {
+		return buffer.size();
+	}
+
+	// Number of moves between keyframes
+	void setKeyframeInterval(const size_t& events) {
+		nKeyframeInterval = (events > 0 ? events : 1);
+	}
+
+	// Start recording a game, once the mines have been placed by the first uncovered cell
+	void begin(const Minefield& field, const int& safeCell);
+
+	// Record a move which has been applied to the minefield (time in seconds since the start of the game).
+	// Moves made before begin() (flags placed before the first uncovered cell) are held until it is called.
+	void addEvent(const Minefield& field, const ReplayEvents& type, const int& cell, const double& time);
+
+	// Write the log (and its keyframe index) to a file and stop recording
+	bool save(const std::string& fname);
+
+	// Discard the current recording (and any held moves)
+	void clear();
+
+private:
+	struct HeldEvent {
+		ReplayEvents type;
+
+		int cell;
+
+		double time;
+	};
+
+	bool bRecording;
+
+	size_t nEvents;
+
+	size_t nKeyframeInterval;
+
+	int nPreviousCell;
+
+	uint64_t nPreviousTime; // In milliseconds
+
+	std::vector<uint8_t> buffer;
+
+	std::vector<uint64_t> keyframes; // Offset of each keyframe
+
+	std::vector<uint64_t> stateWords;
+
+	std::vector<HeldEvent> heldEvents; // Moves made before the recording began
+
+	// Append a move record (without a keyframe)
+	void writeEvent(const ReplayEvents& type, const int& cell, const double& time);
+};
+
+// Plays back a replay log. The file is memory mapped, and seeking restores the nearest keyframe
+// before replaying the (at most one keyframe interval of) remaining moves.
+class ReplayPlayer {
+public:
+	ReplayPlayer();
+
+	~ReplayPlayer();
+
+	bool isOpen() const {
+		return (data != 0x0);
+	}
+
+	int getWidth() const {
+		return nWidth;
+	}
+
+	int getHeight() const {
+		return nHeight;
+	}
+
+	int getMines() const {
+		return (int)layout.size();
+	}
+
+	int getSafeCell() const {
+		return nSafeCell;
+	}
+
+	const std::vector<int>& getLayout() const {
+		return layout;
+	}
+
+	size_t getEventCount() const {
+		return nEvents;
+	}
+
+	// Number of moves applied so far
+	size_t getPosition() const {
+		return nPosition;
+	}
+
+	// Time of the last applied move (in seconds since the start of the game)
+	double getTime() const {
+		return nPreviousTime / 1E3;
+	}
+
+	// Time of the next move (in seconds since the start of the game)
+	double getNextEventTime() const ;
+
+	bool open(const std::string& fname);
+
+	void close();
+
+	// Reset a minefield to the start of the game (mines placed, every cell covered)
+	bool reset(Minefield& field);
+
+	// Apply the next move to a minefield, return false at the end of the log
+	bool step(Minefield& field);
+
+	// Set a minefield to its state after a number of moves
+	bool seek(Minefield& field, const size_t& position);
+
+private:
+	struct Keyframe {
+		size_t nOffset;
+
+		size_t nEvent; // Number of moves applied before the keyframe
+
+		int nCell; // Cell of the last move
+
+		uint64_t nTime; // Time of the last move
+	};
+
+	const uint8_t* data;
+
+	size_t nSize; // Size of the mapped file
+
+	size_t nRecordsBegin; // Offset of the first move
+
+	size_t nRecordsEnd;
+
+	size_t nOffset; // Offset of the next record
+
+	size_t nEvents;
+
+	size_t nPosition;
+
+	int nWidth;
+
+	int nHeight;
+
+	int nSafeCell;
+
+	int nPreviousCell;
+
+	uint64_t nPreviousTime;
+
+	std::vector<int> layout;
+
+	std::vector<Keyframe> keyframes;
+
+	std::vector<uint8_t> fileData; // Used when memory mapping is not available
+
+	// Decode the move at an offset (skipping keyframes), and move the offset to the following record
+	bool readEvent(size_t& offset, ReplayEvents& type, int& cell, uint64_t& time) const ;
+
+	// Read the keyframe at an offset (and optionally its cover state), and move the offset past it
+	bool readKeyframe(size_t& offset, Keyframe& keyframe, std::vector<uint64_t>* words) const ;
+
+	// Scan every record to build the keyframe index (for logs without one)
+	bool buildIndex();
+};
+
+#endif // ifndef Replay_HPP
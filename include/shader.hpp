@@ -0,0 +1,7 @@
+#ifndef Shader_HPP
+#define Shader_HPP
+
+// Compile and link a GLSL shader program, return 0 and print the log on failure
+unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource, const char* name);
+
+#endif // ifndef Shader_HPP
@@ -0,0 +1,93 @@
+#ifndef Snapshot_HPP
+#define Snapshot_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "topology.hpp"
+
+class Minefield;
+
+// Saved state of an unfinished game. The file is a fixed size header followed by the mine, covered,
+// flagged, and unknown bit-planes, stored exactly as Minefield keeps them (each row padded to whole
+// 64-bit words). The file is memory mapped and the planes are copied straight into a minefield, so
+// restoring a game does not need to decode anything.
+class Snapshot {
+public:
+	Snapshot();
+
+	~Snapshot();
+
+	bool isOpen() const {
+		return (data != 0x0);
+	}
+
+	int getWidth() const {
+		return nWidth;
+	}
+
+	int getHeight() const {
+		return nHeight;
+	}
+
+	int getMines() const {
+		return nMines;
+	}
+
+	Topologies getTopology() const {
+		return topology;
+	}
+
+	int getLayerRows() const {
+		return nLayerRows;
+	}
+
+	// Game time when the snapshot was saved (in seconds)
+	double getTime() const {
+		return nTime / 1E3;
+	}
+
+	// Save a minefield and the game time (in seconds). Finished games can not be saved.
+	static bool save(const std::string& fname, const Minefield& field, const double& time);
+
+	bool open(const std::string& fname);
+
+	void close();
+
+	// Resize a minefield to the size (and topology) of the snapshot and restore its mines and cover state
+	bool restore(Minefield& field) const ;
+
+private:
+	const uint8_t* data;
+
+	size_t nSize; // Size of the mapped file
+
+	int nWidth;
+
+	int nHeight;
+
+	int nMines;
+
+	Topologies topology;
+
+	int nLayerRows;
+
+	bool bMinesPlaced; // False if the game was saved before the first cell was uncovered
+
+	uint64_t nTime; // In milliseconds
+
+	size_t nPlaneWords; // Words in each bit-plane
+
+	std::vector<uint8_t> fileData; // Used when memory mapping is not available
+
+	// Get the words of a bit-plane (0: mines, 1-3: cover state)
+	const uint64_t* getPlane(const int& plane) const {
+		return (const uint64_t*)(data + headerSize) + plane * nPlaneWords;
+	}
+
+	static const size_t headerSize = 64;
+};
+
+#endif // ifndef Snapshot_HPP
@@ -0,0 +1,184 @@
+#ifndef Solver_HPP
+#define Solver_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "topology.hpp"
+
+class Minefield;
+
+// Unordered set of cell indices with constant time insertion, removal, and lookup
+class CellSet {
+public:
+	CellSet() :
+		cells(),
+		positions()
+	{
+	}
+
+	size_t size() const {
+		return cells.size();
+	}
+
+	bool empty() const {
+		return cells.empty();
+	}
+
+	bool contains(const int& cell) const {
+		return (positions[cell] >= 0);
+	}
+
+	const std::vector<int>& get() const {
+		return cells;
+	}
+
+	std::vector<int>::const_iterator begin() const {
+		return cells.begin();
+	}
+
+	std::vector<int>::const_iterator end() const {
+		return cells.end();
+	}
+
+	// Remove all cells and set the maximum cell index
+	void reset(const int& nCells);
+
+	void insert(const int& cell);
+
+	void erase(const int& cell);
+
+private:
+	std::vector<int> cells;
+
+	std::vector<int> positions; // Position of each cell in the list (or -1)
+};
+
+enum class SolverStates {
+	HIDDEN, // Covered, and nothing is known about it
+	REVEALED,
+	SAFE, // Covered, but proven not to be a mine
+	MINE // Covered, and proven to be a mine
+};
+
+// Deterministic minesweeper solver. The frontier (covered cells bordering revealed numbers) and the
+// number constraints are updated incrementally from the cells changed on the minefield, and the single
+// cell and subset rules are applied only to the constraints affected by each change.
+class Solver {
+public:
+	Solver();
+
+	int getWidth() const {
+		return nSizeX;
+	}
+
+	int getHeight() const {
+		return nSizeY;
+	}
+
+	SolverStates getState(const int& cell) const {
+		return (SolverStates)states[cell];
+	}
+
+	// Covered, undetermined cells neighboring at least one revealed cell
+	const CellSet& getFrontier() const {
+		return frontier;
+	}
+
+	// Covered cells which are proven to be safe
+	const CellSet& getSafeCells() const {
+		return safeCells;
+	}
+
+	// Covered cells which are proven to contain a mine
+	const std::vector<int>& getMineCells() const {
+		return mineCells;
+	}
+
+	// Number of undetermined mines surrounding a revealed cell
+	int getRemainingMines(const int& cell) const {
+		return remaining[cell];
+	}
+
+	// Number of undetermined cells surrounding a revealed cell
+	int getHiddenNeighbors(const int& cell) const {
+		return hidden[cell];
+	}
+
+	// Number of revealed cells
+	int getRevealedCells() const {
+		return nRevealedCells;
+	}
+
+	// Clear all knowledge and set the size (and topology) of the minefield
+	void reset(const int& width, const int& height, const Topologies& type = Topologies::SQUARE, const int& layerRows = 0);
+
+	// Apply the cells changed on the minefield since its last call to clearChanges() and solve the
+	// affected constraints. Rebuilds everything if the minefield reports a full update.
+	void update(const Minefield& field);
+
+	// Rebuild the frontier and constraints by scanning the entire minefield
+	void rebuild(const Minefield& field);
+
+	// Get the (up to nMaxTopologyNeighbors) neighbors of a cell, returns the number of neighbors
+	int getNeighbors(const int& cell, int* neighbors) const ;
+
+private:
+	int nSizeX;
+
+	int nSizeY;
+
+	Topologies topology;
+
+	TopologyGrid grid;
+
+	int nRevealedCells;
+
+	std::vector<unsigned char> states;
+
+	std::vector<unsigned char> numbers; // Tile value of revealed cells
+
+	std::vector<unsigned char> remaining;
+
+	std::vector<unsigned char> hidden;
+
+	std::vector<unsigned char> queued;
+
+	std::vector<int> workQueue; // Revealed cells whose constraints need to be checked
+
+	CellSet frontier;
+
+	CellSet safeCells;
+
+	std::vector<int> mineCells;
+
+	void reveal(const Minefield& field, const int& cell);
+
+	void setSafe(const int& cell);
+
+	void setMine(const int& cell);
+
+	void enqueue(const int& cell);
+
+	void solve();
+
+	template <class Topology>
+	void solve();
+
+	// Get the hidden neighbors of a revealed cell as a bit mask of the 7x7 window centered on another cell
+	uint64_t getHiddenMask(const int& cell, const int& dx, const int& dy) const ;
+
+	// Mark every cell in a 7x7 window mask as safe or as a mine
+	void applyMask(const int& center, uint64_t mask, const bool& mines);
+
+	// Get the hidden neighbors of a revealed cell, returns the number of hidden neighbors
+	template <class Topology>
+	int getHiddenCells(const int& cell, int* cells) const ;
+
+	// Apply the single cell and subset rules to the constraint of a revealed cell, return true if anything was found
+	template <class Topology>
+	bool checkConstraint(const int& cell);
+};
+
+#endif // ifndef Solver_HPP
@@ -0,0 +1,59 @@
+#ifndef SplitMix_HPP
+#define SplitMix_HPP
+
+#include <random>
+#include <chrono>
+#include <cstdint>
+
+// SplitMix64 generator. The n-th number of a stream is a hash of the seed plus n, so streams are cheap to
+// seed, can be started part way through, and every task or game can use its own independent stream.
+class SplitMix {
+public:
+	SplitMix(const uint64_t& seed, const uint64_t& position = 0) :
+		nState(seed + position * gamma)
+	{
+	}
+
+	uint64_t next() {
+		return mix(nState += gamma);
+	}
+
+	// Get a number in the range [0, range), for range > 0 (unbiased, using Lemire's multiply and shift)
+	int next(const int& range) {
+		const uint64_t bound = (uint64_t)range;
+		uint64_t product = (next() >> 32) * bound;
+		if ((uint32_t)product < bound) { // Reject products which would make some numbers more likely
+			const uint32_t threshold = (uint32_t)(0U - (uint32_t)bound) % (uint32_t)bound; // 2^32 mod range
+			while ((uint32_t)product < threshold) {
+				product = (next() >> 32) * bound;
+			}
+		}
+		return (int)(product >> 32);
+	}
+
+	// Get the seed of an independent stream (e.g. one per thread, game, or board) from a parent seed
+	static uint64_t split(const uint64_t& seed, const uint64_t& stream) {
+		return mix(seed ^ mix(stream));
+	}
+
+	// Get an unpredictable seed
+	static uint64_t randomSeed() {
+		std::random_device device;
+		const uint64_t entropy = ((uint64_t)device() << 32) ^ device();
+		return mix(entropy ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+
+	// SplitMix64 finalizer (also useful for deriving the seed of one stream from another)
+	static uint64_t mix(uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+private:
+	static const uint64_t gamma = 0x9e3779b97f4a7c15ULL; // Counter increment (golden ratio)
+
+	uint64_t nState;
+};
+
+#endif // ifndef SplitMix_HPP
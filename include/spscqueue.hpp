@@ -0,0 +1,81 @@
+#ifndef SpscQueue_HPP
+#define SpscQueue_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+// Fixed size lock-free queue which passes values from exactly one producer thread to exactly one consumer thread
+template <typename T>
+class SpscQueue {
+public:
+	// The capacity is rounded up to a power of two
+	SpscQueue(const size_t& capacity = 1024) :
+		nMask(roundCapacity(capacity) - 1),
+		nHead(0),
+		nTail(0),
+		values(nMask + 1)
+	{
+	}
+
+	size_t getCapacity() const {
+		return nMask + 1;
+	}
+
+	bool empty() const {
+		return (nHead.load(std::memory_order_acquire) == nTail.load(std::memory_order_acquire));
+	}
+
+	// Change the capacity and remove all values (neither thread may be using the queue)
+	void resize(const size_t& capacity) {
+		nMask = roundCapacity(capacity) - 1;
+		values.assign(nMask + 1, T());
+		nHead.store(0, std::memory_order_relaxed);
+		nTail.store(0, std::memory_order_relaxed);
+	}
+
+	// Add a value to the back of the queue, return false if the queue is full (producer thread only)
+	bool push(const T& value) {
+		const size_t tail = nTail.load(std::memory_order_relaxed);
+		if (tail - nHead.load(std::memory_order_acquire) > nMask)
+			return false;
+		values[tail & nMask] = value;
+		nTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Remove the value at the front of the queue, return false if the queue is empty (consumer thread only)
+	bool pop(T& value) {
+		const size_t head = nHead.load(std::memory_order_relaxed);
+		if (head == nTail.load(std::memory_order_acquire))
+			return false;
+		value = values[head & nMask];
+		nHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	static const size_t nCacheLine = 64;
+
+	size_t nMask;
+
+	std::atomic<size_t> nHead; // Next value to pop (only written by the consumer)
+
+	char headPadding[nCacheLine]; // Keep the producer and consumer indices on separate cache lines
+
+	std::atomic<size_t> nTail; // Next slot to push to (only written by the producer)
+
+	char tailPadding[nCacheLine];
+
+	std::vector<T> values;
+
+	static size_t roundCapacity(const size_t& capacity) {
+		size_t rounded = 1;
+		while (rounded < capacity) {
+			rounded <<= 1;
+		}
+		return rounded;
+	}
+};
+
+#endif // ifndef SpscQueue_HPP
@@ -0,0 +1,65 @@
+#ifndef ThreadPool_HPP
+#define ThreadPool_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Work-stealing thread pool. Every worker owns a task queue, tasks pushed from inside a worker go to
+// the back of its own queue, and idle workers steal from the front of the other queues.
+class ThreadPool {
+public:
+	// Use one worker per hardware thread if the number of threads is zero
+	ThreadPool(const unsigned int& nThreads = 0);
+
+	~ThreadPool();
+
+	size_t getThreadCount() const {
+		return threads.size();
+	}
+
+	// Add a task to the pool
+	void push(const std::function<void()>& task);
+
+	// Block until every task has finished (the calling thread runs tasks while it waits)
+	void wait();
+
+private:
+	struct TaskQueue {
+		std::mutex lock;
+
+		std::deque<std::function<void()> > tasks;
+	};
+
+	std::atomic<bool> bStop;
+
+	std::atomic<size_t> nQueued; // Tasks waiting in a queue
+
+	std::atomic<size_t> nPending; // Tasks waiting or running
+
+	std::atomic<size_t> nNextQueue; // Queue used for tasks pushed from outside the pool
+
+	std::mutex sleepLock;
+
+	std::condition_variable wake;
+
+	std::condition_variable done;
+
+	std::vector<std::unique_ptr<TaskQueue> > queues;
+
+	std::vector<std::thread> threads;
+
+	// Pop a task from a queue (or steal one from another queue) and run it, return false if all queues are empty
+	bool runTask(const size_t& index);
+
+	void finishTask();
+
+	void workerLoop(const size_t& index);
+};
+
+#endif // ifndef ThreadPool_HPP
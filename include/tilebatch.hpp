@@ -0,0 +1,126 @@
+#ifndef TileBatch_HPP
+#define TileBatch_HPP
+
+#include <vector>
+
+// Draws the visible part of the minefield, the digit counters, and the smiley face with a single instanced draw call.
+// Each instance is one sprite from the tile atlas; only the per-instance sprite index
+// (one byte) is stored in a buffer and positions are computed in the vertex shader.
+class TileBatch {
+public:
+	TileBatch();
+
+	bool isReady() const {
+		return (nProgram != 0);
+	}
+
+	int getCells() const {
+		return nColumns * nRows;
+	}
+
+	// Return true if any tiles, counter digits, or the face changed since the last draw
+	bool isDirty() const {
+		return !dirtyInstances.empty();
+	}
+
+	// Compile the shader program and upload the RGBA sprite atlas (requires OpenGL 3.3)
+	bool initialize(const unsigned char* atlas, const int& width, const int& height);
+
+	// Add a grid of equally sized sprites (cols x rows, starting at x0, y0) and return the index of the first one
+	int addSprites(const int& x0, const int& y0, const int& w, const int& h, const int& cols, const int& rows);
+
+	void setScreenSize(const int& width, const int& height);
+
+	// Set the position of the top left corner of tile (0, 0) and the size of the minefield (in tiles).
+	// Resets the grid view so that the whole grid is drawn unscaled.
+	void setGrid(const int& x, const int& y, const int& cols, const int& rows, const int& tileSize);
+
+	// Reserve space for grids of up to this many tiles, so that resizing the grid later does not allocate
+	void reserve(const int& cells);
+
+	// Scroll the grid by (scrollX, scrollY) unscaled pixels, scale it, and only draw the part of it
+	// inside a width x height rectangle at the grid origin (in screen pixels)
+	void setGridView(const int& scrollX, const int& scrollY, const float& scale, const int& width, const int& height);
+
+	// Shift the odd rows of the minefield right by a number of unscaled pixels (for hexagonal minefields).
+	// The first row of the grid is row firstRow of the minefield.
+	void setRowShift(const int& shift, const int& firstRow);
+
+	// Set the position of the top left corner of a three digit counter
+	void setCounterPosition(const int& counter, const int& x, const int& y);
+
+	// Set the value displayed by a three digit counter (values over 999 are displayed as 999)
+	void setCounter(const int& counter, const int& value, const int& firstDigitSprite);
+
+	// Set the position of the top left corner of the smiley face
+	void setFacePosition(const int& x, const int& y);
+
+	void setFace(const int& sprite);
+
+	void setTile(const int& index, const unsigned char& sprite);
+
+	void draw();
+
+private:
+	static const int nCounters = 2;
+
+	static const int nCounterDigits = 3 * nCounters;
+
+	static const int nFixedInstances = nCounterDigits + 1; // Counter digits and the smiley face, followed by the minefield
+
+	static const int nMaxSprites = 32;
+
+	int nColumns;
+
+	int nRows;
+
+	int nTileSize;
+
+	int nOriginX;
+
+	int nOriginY;
+
+	int nScrollX;
+
+	int nScrollY;
+
+	double dGridScale;
+
+	int nClipWidth;
+
+	int nClipHeight;
+
+	int nRowShift;
+
+	int nFirstRow;
+
+	int nScreenWidth;
+
+	int nScreenHeight;
+
+	int nDirtyLow;
+
+	int nDirtyHigh;
+
+	unsigned int nProgram;
+
+	unsigned int nVertexArray;
+
+	unsigned int nInstanceBuffer;
+
+	unsigned int nAtlasTexture;
+
+	std::vector<float> spriteRects;
+
+	std::vector<float> fixedPositions;
+
+	std::vector<unsigned char> instances;
+
+	std::vector<int> dirtyInstances;
+
+	void markDirty(const int& instance);
+
+	void upload();
+};
+
+#endif // ifndef TileBatch_HPP
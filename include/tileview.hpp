@@ -0,0 +1,62 @@
+#ifndef TileView_HPP
+#define TileView_HPP
+
+#include <vector>
+
+class Minefield;
+
+// Tracks which sprite is currently displayed for every cell of a minefield, and which
+// cells need to be redrawn because their state or their highlight (press or chord preview) changed.
+class TileView {
+public:
+	TileView();
+
+	bool isFullRedraw() const {
+		return bFullRedraw;
+	}
+
+	// Cells whose displayed sprite changed since the last call to clearDirty()
+	const std::vector<int>& getDirtyCells() const {
+		return dirtyCells;
+	}
+
+	unsigned char getTile(const int& index) const {
+		return tiles[index];
+	}
+
+	// Force every cell to be redrawn on the next update
+	void invalidate() {
+		bFullRedraw = true;
+	}
+
+	// Compare the minefield (and the currently highlighted cells) against the displayed sprites.
+	// Only the changed cells reported by the minefield and the old and new highlights are checked,
+	// unless a full redraw is required.
+	void update(const Minefield& field, const int& pressedCell, const std::vector<int>& previewCells);
+
+	void clearDirty();
+
+	// Get the sprite displayed for a cell with a given cover state and tile value
+	static unsigned char selectTile(const unsigned char& cover, const unsigned char& cell, const bool& highlighted);
+
+private:
+	bool bFullRedraw;
+
+	int nPressedCell;
+
+	std::vector<unsigned char> tiles;
+
+	std::vector<int> dirtyCells;
+
+	std::vector<int> highlightCells;
+
+	std::vector<int> previousCells; // Cells highlighted on the previous update
+
+	unsigned char getTile(const Minefield& field, const int& index) const ;
+
+	bool isHighlighted(const int& index) const ;
+
+	void updateCell(const Minefield& field, const int& index);
+};
+
+#endif // ifndef TileView_HPP
@@ -0,0 +1,207 @@
+#ifndef Topology_HPP
+#define Topology_HPP
+
+#include <string>
+
+// Neighbor policies of the supported board shapes. Routines which visit neighbors are templated on one of
+// these, so the neighbor loops are inlined for each shape. Cells are always stored in rows of the minefield
+// (index = y * width + x), the shapes only change which cells are neighbors.
+//
+// Numbers count the mines of every neighbor, but a cascade from a blank cell only uncovers the cells which
+// share an edge with it (getFillNeighbors()). For square and torus minefields these are the four cells in
+// the same row and column, as in the original game; for hex and cubic minefields every neighbor shares an edge.
+
+enum class Topologies {
+	SQUARE, // Eight neighbors, clamped at the edges
+	TORUS, // Eight neighbors, wrapping around the edges
+	HEX, // Six neighbors, odd rows shifted right by half a cell
+	CUBIC // Six neighbors, layers of rows stacked in the minefield
+};
+
+// Size of a minefield, as seen by a topology
+struct TopologyGrid {
+	int nSizeX;
+
+	int nSizeY;
+
+	int nLayerRows; // Rows in each layer of a cubic minefield
+};
+
+struct SquareTopology {
+	static const Topologies type = Topologies::SQUARE;
+
+	static const int nMaxNeighbors = 8;
+
+	static const bool bOffsetRows = false;
+
+	static int getNeighbors(const TopologyGrid& grid, const int& x, const int& y, int* neighbors) {
+		int count = 0;
+		for (int yp = y - 1; yp <= y + 1; yp++) {
+			if (yp < 0 || yp >= grid.nSizeY)
+				continue;
+			for (int xp = x - 1; xp <= x + 1; xp++) {
+				if (xp < 0 || xp >= grid.nSizeX || (xp == x && yp == y))
+					continue;
+				neighbors[count++] = yp * grid.nSizeX + xp;
+			}
+		}
+		return count;
+	}
+
+	static const int nMaxFillNeighbors = 4;
+
+	// Minefield uses a scanline fill for square minefields instead, which uncovers the same cells
+	static int getFillNeighbors(const TopologyGrid& grid, const int& x, const int& y, int* neighbors) {
+		int count = 0;
+		if (x > 0)
+			neighbors[count++] = y * grid.nSizeX + x - 1;
+		if (x + 1 < grid.nSizeX)
+			neighbors[count++] = y * grid.nSizeX + x + 1;
+		if (y > 0)
+			neighbors[count++] = (y - 1) * grid.nSizeX + x;
+		if (y + 1 < grid.nSizeY)
+			neighbors[count++] = (y + 1) * grid.nSizeX + x;
+		return count;
+	}
+};
+
+// At least three rows and columns are needed so that no cell is a neighbor twice
+struct TorusTopology {
+	static const Topologies type = Topologies::TORUS;
+
+	static const int nMaxNeighbors = 8;
+
+	static const bool bOffsetRows = false;
+
+	static int getNeighbors(const TopologyGrid& grid, const int& x, const int& y, int* neighbors) {
+		const int xs[3] = { (x > 0 ? x - 1 : grid.nSizeX - 1), x, (x + 1 < grid.nSizeX ? x + 1 : 0) };
+		const int ys[3] = { (y > 0 ? y - 1 : grid.nSizeY - 1), y, (y + 1 < grid.nSizeY ? y + 1 : 0) };
+		int count = 0;
+		for (int j = 0; j < 3; j++) {
+			for (int i = 0; i < 3; i++) {
+				if (i != 1 || j != 1)
+					neighbors[count++] = ys[j] * grid.nSizeX + xs[i];
+			}
+		}
+		return count;
+	}
+
+	static const int nMaxFillNeighbors = 4;
+
+	static int getFillNeighbors(const TopologyGrid& grid, const int& x, const int& y, int* neighbors) {
+		neighbors[0] = y * grid.nSizeX + (x > 0 ? x - 1 : grid.nSizeX - 1);
+		neighbors[1] = y * grid.nSizeX + (x + 1 < grid.nSizeX ? x + 1 : 0);
+		neighbors[2] = (y > 0 ? y - 1 : grid.nSizeY - 1) * grid.nSizeX + x;
+		neighbors[3] = (y + 1 < grid.nSizeY ? y + 1 : 0) * grid.nSizeX + x;
+		return 4;
+	}
+};
+
+struct HexTopology {
+	static const Topologies type = Topologies::HEX;
+
+	static const int nMaxNeighbors = 6;
+
+	static const bool bOffsetRows = true;
+
+	static int getNeighbors(const TopologyGrid& grid, const int& x, const int& y, int* neighbors) {
+		const int shift = (y & 1); // Diagonal neighbors of odd rows are one cell further right
+		int count = 0;
+		if (x > 0)
+			neighbors[count++] = y * grid.nSizeX + x - 1;
+		if (x + 1 < grid.nSizeX)
+			neighbors[count++] = y * grid.nSizeX + x + 1;
+		for (int yp = y - 1; yp <= y + 1; yp += 2) {
+			if (yp < 0 || yp >= grid.nSizeY)
+				continue;
+			if (x + shift - 1 >= 0)
+				neighbors[count++] = yp * grid.nSizeX + x + shift - 1;
+			if (x + shift < grid.nSizeX)
+				neighbors[count++] = yp * grid.nSizeX + x + shift;
+		}
+		return count;
+	}
+
+	static const int nMaxFillNeighbors = nMaxNeighbors;
+
+	static int getFillNeighbors(const TopologyGrid& grid, const int& x, const int& y, int* neighbors) {
+		return getNeighbors(grid, x, y, neighbors);
+	}
+};
+
+// The same cell of the layers above and below is a neighbor, along with the four cells next to it in its
+// own layer (the 26 cell neighborhood would need numbers past eight, which the tiles can not show)
+struct CubicTopology {
+	static const Topologies type = Topologies::CUBIC;
+
+	static const int nMaxNeighbors = 6;
+
+	static const bool bOffsetRows = false;
+
+	static int getNeighbors(const TopologyGrid& grid, const int& x, const int& y, int* neighbors) {
+		const int row = y % grid.nLayerRows;
+		int count = 0;
+		if (x > 0)
+			neighbors[count++] = y * grid.nSizeX + x - 1;
+		if (x + 1 < grid.nSizeX)
+			neighbors[count++] = y * grid.nSizeX + x + 1;
+		if (row > 0)
+			neighbors[count++] = (y - 1) * grid.nSizeX + x;
+		if (row + 1 < grid.nLayerRows)
+			neighbors[count++] = (y + 1) * grid.nSizeX + x;
+		if (y >= grid.nLayerRows)
+			neighbors[count++] = (y - grid.nLayerRows) * grid.nSizeX + x;
+		if (y + grid.nLayerRows < grid.nSizeY)
+			neighbors[count++] = (y + grid.nLayerRows) * grid.nSizeX + x;
+		return count;
+	}
+
+	static const int nMaxFillNeighbors = nMaxNeighbors;
+
+	static int getFillNeighbors(const TopologyGrid& grid, const int& x, const int& y, int* neighbors) {
+		return getNeighbors(grid, x, y, neighbors);
+	}
+};
+
+// Largest number of neighbors of any topology
+const int nMaxTopologyNeighbors = 8;
+
+// Get a topology from its name (square, torus, hex, or cubic), return false if the name is not known
+inline bool getTopology(const std::string& name, Topologies& topology) {
+	if (name == "square")
+		topology = Topologies::SQUARE;
+	else if (name == "torus")
+		topology = Topologies::TORUS;
+	else if (name == "hex")
+		topology = Topologies::HEX;
+	else if (name == "cubic")
+		topology = Topologies::CUBIC;
+	else
+		return false;
+	return true;
+}
+
+inline std::string getTopologyName(const Topologies& topology) {
+	switch (topology) {
+	case Topologies::TORUS: return "torus";
+	case Topologies::HEX: return "hex";
+	case Topologies::CUBIC: return "cubic";
+	default:
+		break;
+	}
+	return "square";
+}
+
+// Return true if the odd rows of a topology are drawn shifted right by half a cell
+inline bool hasOffsetRows(const Topologies& topology) {
+	switch (topology) {
+	case Topologies::TORUS: return TorusTopology::bOffsetRows;
+	case Topologies::HEX: return HexTopology::bOffsetRows;
+	case Topologies::CUBIC: return CubicTopology::bOffsetRows;
+	default:
+		break;
+	}
+	return SquareTopology::bOffsetRows;
+}
+
+#endif // ifndef Topology_HPP
@@ -0,0 +1,88 @@
+#include <cstdlib>
+#include <new>
+
+#include "alloccount.hpp"
+
+#ifdef OTTSWEEPER_COUNT_ALLOCATIONS
+
+namespace {
+
+thread_local unsigned long long nThreadAllocations = 0;
+
+void* allocate(std::size_t size) {
+	nThreadAllocations++;
+	if (size == 0)
+		size = 1;
+	void* ptr = 0x0;
+	while ((ptr = std::malloc(size)) == 0x0) { // Give the new handler a chance to free some memory
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+		handler();
+	}
+	return ptr;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+	return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return allocate(size);
+	}
+	catch (...) {
+		return 0x0;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return allocate(size);
+	}
+	catch (...) {
+		return 0x0;
+	}
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	std::free(ptr);
+}
+
+bool AllocationCounter::isEnabled() {
+	return true;
+}
+
+unsigned long long AllocationCounter::getAllocations() {
+	return nThreadAllocations;
+}
+
+#else
+
+bool AllocationCounter::isEnabled() {
+	return false;
+}
+
+unsigned long long AllocationCounter::getAllocations() {
+	return 0;
+}
+
+#endif // ifdef OTTSWEEPER_COUNT_ALLOCATIONS
@@ -0,0 +1,9 @@
+#include "atlas.hpp"
+
+// Used when no atlas image was found at build time (textures are loaded from a file instead)
+bool getEmbeddedAtlas(const unsigned char*& data, int& width, int& height) {
+	data = 0x0;
+	width = 0;
+	height = 0;
+	return false;
+}
@@ -0,0 +1,55 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+
+#include "OTTTexture.hpp"
+
+// Convert the sprite atlas image to RGBA and write it as a source file which is compiled into the game,
+// so that the game does not need to read and decode the image when it starts
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		std::cout << " Usage: " << argv[0] << " <image> <output source file>" << std::endl;
+		return 1;
+	}
+	const std::string imageFilePath = argv[1];
+	const std::string outputFilePath = argv[2];
+
+	// Load the image the same way the game does
+	OTTTexture image(imageFilePath);
+	image.increaseColorDepth(4);
+	const unsigned char* pixels = image.get();
+	const int width = image.getWidth();
+	const int height = image.getHeight();
+	if (!pixels || width <= 0 || height <= 0) {
+		std::cout << " Error! Failed to load sprite atlas image (" << imageFilePath << ")." << std::endl;
+		return 1;
+	}
+
+	std::ofstream ofile(outputFilePath.c_str());
+	if (!ofile.good()) {
+		std::cout << " Error! Failed to open output file (" << outputFilePath << ")." << std::endl;
+		return 1;
+	}
+	ofile << "// Generated by ottsweeper_atlas from " << imageFilePath << " (do not edit)" << std::endl;
+	ofile << "#include \"atlas.hpp\"" << std::endl << std::endl;
+	ofile << "static const unsigned char atlasPixels[" << 4 * width * height << "] = {";
+	for (int i = 0; i < 4 * width * height; i++) {
+		if (i % 32 == 0)
+			ofile << std::endl << "\t";
+		ofile << (int)pixels[i] << ",";
+	}
+	ofile << std::endl << "};" << std::endl << std::endl;
+	ofile << "bool getEmbeddedAtlas(const unsigned char*& data, int& width, int& height) {" << std::endl;
+	ofile << "\tdata = atlasPixels;" << std::endl;
+	ofile << "\twidth = " << width << ";" << std::endl;
+	ofile << "\theight = " << height << ";" << std::endl;
+	ofile << "\treturn true;" << std::endl;
+	ofile << "}" << std::endl;
+	ofile.close();
+	if (!ofile.good()) {
+		std::cout << " Error! Failed to write output file (" << outputFilePath << ")." << std::endl;
+		return 1;
+	}
+	std::cout << " Converted " << width << " x " << height << " sprite atlas to " << outputFilePath << std::endl;
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include <GL/glew.h>
+
+#include <iostream>
+
+#include "background.hpp"
+#include "shader.hpp"
+
+// Panel styles (must match the fragment shader)
+const int solidPanel = 0;
+const int raisedPanel = 1;
+const int sunkenPanel = 2;
+
+const char* backgroundVertexSource =
+	"#version 330\n"
+	"uniform vec2 screenSize;\n"
+	"out vec2 screenCoord;\n"
+	"void main() {\n"
+	"	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+	"	screenCoord = corner * screenSize;\n"
+	"	gl_Position = vec4(2.0 * corner.x - 1.0, 1.0 - 2.0 * corner.y, 0.0, 1.0);\n"
+	"}\n";
+
+// Bevels are three pixels wide. Where the light and dark edges of a raised panel meet, the corner pixels
+// are left gray. Sunken panels give those pixels to their top and bottom edges instead.
+const char* backgroundFragmentSource =
+	"#version 330\n"
+	"uniform ivec4 panelRects[8];\n"
+	"uniform int panelStyles[8];\n"
+	"uniform vec3 panelColors[8];\n"
+	"uniform int panelCount;\n"
+	"in vec2 screenCoord;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	const vec3 face = vec3(192.0 / 255.0);\n"
+	"	const vec3 light = vec3(1.0);\n"
+	"	const vec3 shadow = vec3(128.0 / 255.0);\n"
+	"	ivec2 p = ivec2(floor(screenCoord));\n"
+	"	vec3 c = face;\n"
+	"	for (int i = 0; i < panelCount; i++) {\n"
+	"		ivec4 r = panelRects[i];\n"
+	"		if (any(lessThan(p, r.xy)) || any(greaterThan(p, r.zw)))\n"
+	"			continue;\n"
+	"		if (panelStyles[i] == 0) {\n"
+	"			c = panelColors[i];\n"
+	"			continue;\n"
+	"		}\n"
+	"		int top = p.y - r.y;\n"
+	"		int topLeft = min(p.x - r.x, top);\n"
+	"		int bottomRight = min(r.z - p.x, r.w - p.y);\n"
+	"		vec3 topLeftColor = (panelStyles[i] == 1 ? light : shadow);\n"
+	"		vec3 bottomRightColor = (panelStyles[i] == 1 ? shadow : light);\n"
+	"		if (min(topLeft, bottomRight) >= 3)\n"
+	"			c = face;\n"
+	"		else if (topLeft < bottomRight)\n"
+	"			c = topLeftColor;\n"
+	"		else if (bottomRight < topLeft)\n"
+	"			c = bottomRightColor;\n"
+	"		else if (panelStyles[i] == 2)\n"
+	"			c = (top == topLeft ? topLeftColor : bottomRightColor);\n"
+	"		else\n"
+	"			c = face;\n"
+	"	}\n"
+	"	color = vec4(c, 1.0);\n"
+	"}\n";
+
+Background::Background() :
+	nScreenWidth(1),
+	nScreenHeight(1),
+	nProgram(0),
+	nVertexArray(0),
+	panelRects(),
+	panelStyles(),
+	panelColors()
+{
+}
+
+bool Background::initialize() {
+	nProgram = createShaderProgram(backgroundVertexSource, backgroundFragmentSource, "background");
+	if (nProgram == 0)
+		return false;
+
+	// Vertices are generated from gl_VertexID, but a vertex array must still be bound
+	glGenVertexArrays(1, &nVertexArray);
+
+	return true;
+}
+
+void Background::setScreenSize(const int& width, const int& height) {
+	nScreenWidth = width;
+	nScreenHeight = height;
+}
+
+void Background::clear() {
+	panelRects.clear();
+	panelStyles.clear();
+	panelColors.clear();
+}
+
+bool Background::addPanel(const int& x0, const int& y0, const int& x1, const int& y1, const bool& raised) {
+	return addPanel(x0, y0, x1, y1, (raised ? raisedPanel : sunkenPanel), 0.f, 0.f, 0.f);
+}
+
+bool Background::addRectangle(const int& x0, const int& y0, const int& x1, const int& y1, const float& red, const float& green, const float& blue) {
+	return addPanel(x0, y0, x1, y1, solidPanel, red, green, blue);
+}
+
+void Background::draw() {
+	if (!isReady())
+		return;
+	glUseProgram(nProgram);
+	glUniform2f(glGetUniformLocation(nProgram, "screenSize"), (float)nScreenWidth, (float)nScreenHeight);
+	glUniform1i(glGetUniformLocation(nProgram, "panelCount"), (GLint)panelStyles.size());
+	if (!panelStyles.empty()) {
+		glUniform4iv(glGetUniformLocation(nProgram, "panelRects"), (GLsizei)panelStyles.size(), panelRects.data());
+		glUniform1iv(glGetUniformLocation(nProgram, "panelStyles"), (GLsizei)panelStyles.size(), panelStyles.data());
+		glUniform3fv(glGetUniformLocation(nProgram, "panelColors"), (GLsizei)panelStyles.size(), panelColors.data());
+	}
+	glBindVertexArray(nVertexArray);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+bool Background::addPanel(const int& x0, const int& y0, const int& x1, const int& y1, const int& style, const float& red, const float& green, const float& blue) {
+	if ((int)panelStyles.size() >= nMaxPanels) {
+		std::cout << " Warning! Background panel limit (" << nMaxPanels << ") reached." << std::endl;
+		return false;
+	}
+	panelRects.push_back(x0);
+	panelRects.push_back(y0);
+	panelRects.push_back(x1);
+	panelRects.push_back(y1);
+	panelStyles.push_back(style);
+	panelColors.push_back(red);
+	panelColors.push_back(green);
+	panelColors.push_back(blue);
+	return true;
+}
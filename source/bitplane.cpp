@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define OTTSWEEPER_HAVE_SSE2
+	#include <emmintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
+
+#include "bitplane.hpp"
+#include "bitplane_kernels.hpp"
+
+#ifdef OTTSWEEPER_HAVE_AVX2
+// Defined in bitplane_avx2.cpp (compiled with AVX2 enabled)
+void countNeighborWordsAVX2(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* b0, uint64_t* b1, uint64_t* b2, uint64_t* b3, const int& nWords);
+#endif
+
+namespace {
+
+#ifdef OTTSWEEPER_HAVE_SSE2
+// SSE2 (128 cells per step) operations
+struct SSE2Ops {
+	typedef __m128i Type;
+
+	static const int nLanes = 2;
+
+	static Type load(const uint64_t* ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)); }
+
+	static void store(uint64_t* ptr, const Type& val) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), val); }
+
+	static Type bitAnd(const Type& a, const Type& b) { return _mm_and_si128(a, b); }
+
+	static Type bitOr(const Type& a, const Type& b) { return _mm_or_si128(a, b); }
+
+	static Type bitXor(const Type& a, const Type& b) { return _mm_xor_si128(a, b); }
+
+	static Type shiftLeft1(const Type& a) { return _mm_slli_epi64(a, 1); }
+
+	static Type shiftLeft63(const Type& a) { return _mm_slli_epi64(a, 63); }
+
+	static Type shiftRight1(const Type& a) { return _mm_srli_epi64(a, 1); }
+
+	static Type shiftRight63(const Type& a) { return _mm_srli_epi64(a, 63); }
+};
+
+void countNeighborWordsSSE2(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* b0, uint64_t* b1, uint64_t* b2, uint64_t* b3, const int& nWords) {
+	const int nVector = nWords - (nWords % SSE2Ops::nLanes);
+	countNeighborWords<SSE2Ops>(up, mid, down, b0, b1, b2, b3, 0, nVector);
+	countNeighborWords<ScalarOps>(up, mid, down, b0, b1, b2, b3, nVector, nWords);
+}
+#endif
+
+void countNeighborWordsScalar(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* b0, uint64_t* b1, uint64_t* b2, uint64_t* b3, const int& nWords) {
+	countNeighborWords<ScalarOps>(up, mid, down, b0, b1, b2, b3, 0, nWords);
+}
+
+typedef void (*NeighborKernel)(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, uint64_t*, uint64_t*, uint64_t*, const int&);
+
+struct KernelInfo {
+	NeighborKernel kernel;
+
+	std::string name;
+};
+
+#ifdef OTTSWEEPER_HAVE_AVX2
+bool cpuSupportsAVX2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) // OSXSAVE and AVX
+		return false;
+	if ((_xgetbv(0) & 0x6) != 0x6) // OS saves XMM and YMM registers
+		return false;
+	__cpuidex(info, 7, 0);
+	return ((info[1] & (1 << 5)) != 0);
+#elif defined(__GNUC__)
+	__builtin_cpu_init();
+	return (__builtin_cpu_supports("avx2") != 0);
+#else
+	return false;
+#endif
+}
+#endif
+
+// Select the fastest kernel supported by the cpu (may be overridden with the OTTSWEEPER_KERNEL environment variable)
+KernelInfo selectKernel() {
+	const char* request = std::getenv("OTTSWEEPER_KERNEL");
+	const std::string requested = (request ? request : "");
+	KernelInfo info = { countNeighborWordsScalar, "scalar" };
+	if (requested == "scalar")
+		return info;
+#ifdef OTTSWEEPER_HAVE_SSE2
+	info.kernel = countNeighborWordsSSE2;
+	info.name = "sse2";
+	if (requested == "sse2")
+		return info;
+#endif
+#ifdef OTTSWEEPER_HAVE_AVX2
+	if (cpuSupportsAVX2()) {
+		info.kernel = countNeighborWordsAVX2;
+		info.name = "avx2";
+	}
+#endif
+	return info;
+}
+
+const KernelInfo& getKernel() {
+	static const KernelInfo info = selectKernel();
+	return info;
+}
+
+// Lookup table which spreads the 8 bits of a byte into the lowest bit of 8 bytes
+struct SpreadTable {
+	uint64_t table[256];
+
+	SpreadTable() {
+		for (int i = 0; i < 256; i++) {
+			table[i] = 0;
+			for (int bit = 0; bit < 8; bit++) {
+				if (i & (1 << bit))
+					table[i] |= (1ULL << (8 * bit));
+			}
+		}
+	}
+};
+
+const SpreadTable spread;
+
+} // namespace
+
+BitPlane::BitPlane() :
+	nWidth(0),
+	nHeight(0),
+	nWords(0),
+	nStride(2),
+	data(2 * 2, 0)
+{
+}
+
+BitPlane::BitPlane(const int& width, const int& height) :
+	BitPlane()
+{
+	resize(width, height);
+}
+
+void BitPlane::resize(const int& width, const int& height) {
+	nWidth = width;
+	nHeight = height;
+	nWords = (width + 63) / 64;
+	nStride = nWords + 2;
+	data.assign((size_t)nStride * (nHeight + 2), 0);
+}
+
+void BitPlane::clear() {
+	std::fill(data.begin(), data.end(), 0);
+}
+
+void BitPlane::fill() {
+	if (nWords == 0)
+		return;
+	const uint64_t lastMask = ((nWidth & 63) == 0 ? ~0ULL : (1ULL << (nWidth & 63)) - 1);
+	for (int y = 0; y < nHeight; y++) {
+		uint64_t* row = getRow(y);
+		std::fill(row, row + nWords - 1, ~0ULL);
+		row[nWords - 1] = lastMask;
+	}
+}
+
+int BitPlane::count() const {
+	int total = 0;
+	for (auto word = data.begin(); word != data.end(); word++) {
+		total += countBits(*word);
+	}
+	return total;
+}
+
+void BitPlane::copyTo(uint64_t* words) const {
+	for (int y = 0; y < nHeight; y++) {
+		const uint64_t* row = getRow(y);
+		std::copy(row, row + nWords, words + (size_t)y * nWords);
+	}
+}
+
+void BitPlane::copyFrom(const uint64_t* words) {
+	for (int y = 0; y < nHeight; y++) {
+		std::copy(words + (size_t)y * nWords, words + (size_t)(y + 1) * nWords, getRow(y));
+	}
+}
+
+void BitPlane::countNeighbors(std::vector<unsigned char>& counts, const unsigned char& setValue) const {
+	counts.resize((size_t)nWidth * nHeight);
+	if (nWords == 0)
+		return;
+	NeighborKernel kernel = getKernel().kernel;
+	static thread_local std::vector<uint64_t> planes; // Kept between calls, so that placing mines does not allocate
+	if (planes.size() < 4 * (size_t)nWords)
+		planes.resize(4 * (size_t)nWords);
+	uint64_t* b0 = &planes[0];
+	uint64_t* b1 = b0 + nWords;
+	uint64_t* b2 = b1 + nWords;
+	uint64_t* b3 = b2 + nWords;
+	for (int y = 0; y < nHeight; y++) { // Over all rows
+		const uint64_t* mid = getRow(y);
+		kernel(getRow(y - 1), mid, getRow(y + 1), b0, b1, b2, b3, nWords);
+		unsigned char* dest = &counts[(size_t)y * nWidth];
+		for (int w = 0; w < nWords; w++) { // Expand count planes into one byte per cell
+			const int nCells = std::min(64, nWidth - 64 * w);
+			uint64_t p0 = b0[w], p1 = b1[w], p2 = b2[w], p3 = b3[w], set = mid[w];
+			for (int cell = 0; cell < nCells; cell += 8) { // Over 8 cells at a time
+				uint64_t cells = spread.table[p0 & 0xff];
+				cells |= spread.table[p1 & 0xff] << 1;
+				cells |= spread.table[p2 & 0xff] << 2;
+				cells |= spread.table[p3 & 0xff] << 3;
+				const uint64_t setCells = spread.table[set & 0xff];
+				cells = (cells & ~(setCells * 0xff)) | (setCells * setValue);
+				if (nCells - cell >= 8)
+					std::memcpy(dest, &cells, 8); // Little endian byte order
+				else
+					std::memcpy(dest, &cells, nCells - cell);
+				dest += 8;
+				p0 >>= 8;
+				p1 >>= 8;
+				p2 >>= 8;
+				p3 >>= 8;
+				set >>= 8;
+			}
+		}
+	}
+}
+
+std::string BitPlane::getKernelName() {
+	return getKernel().name;
+}
@@ -0,0 +1,40 @@
+#include <immintrin.h>
+
+#include "bitplane_kernels.hpp"
+
+// This file is compiled with AVX2 enabled and must only be called after checking cpu support
+
+namespace {
+
+// AVX2 (256 cells per step) operations
+struct AVX2Ops {
+	typedef __m256i Type;
+
+	static const int nLanes = 4;
+
+	static Type load(const uint64_t* ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)); }
+
+	static void store(uint64_t* ptr, const Type& val) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), val); }
+
+	static Type bitAnd(const Type& a, const Type& b) { return _mm256_and_si256(a, b); }
+
+	static Type bitOr(const Type& a, const Type& b) { return _mm256_or_si256(a, b); }
+
+	static Type bitXor(const Type& a, const Type& b) { return _mm256_xor_si256(a, b); }
+
+	static Type shiftLeft1(const Type& a) { return _mm256_slli_epi64(a, 1); }
+
+	static Type shiftLeft63(const Type& a) { return _mm256_slli_epi64(a, 63); }
+
+	static Type shiftRight1(const Type& a) { return _mm256_srli_epi64(a, 1); }
+
+	static Type shiftRight63(const Type& a) { return _mm256_srli_epi64(a, 63); }
+};
+
+} // namespace
+
+void countNeighborWordsAVX2(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* b0, uint64_t* b1, uint64_t* b2, uint64_t* b3, const int& nWords) {
+	const int nVector = nWords - (nWords % AVX2Ops::nLanes);
+	countNeighborWords<AVX2Ops>(up, mid, down, b0, b1, b2, b3, 0, nVector);
+	countNeighborWords<ScalarOps>(up, mid, down, b0, b1, b2, b3, nVector, nWords);
+}
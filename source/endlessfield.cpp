@@ -0,0 +1,228 @@
+#include <cstring>
+
+#include "endlessfield.hpp"
+#include "splitmix.hpp"
+
+EndlessField::EndlessField() :
+	EndlessField(0.15)
+{
+}
+
+EndlessField::EndlessField(const double& density) :
+	bFirstCell(true),
+	gameState(GameStates::NORMAL),
+	dDensity(0),
+	nThreshold(0),
+	nSeed(0),
+	nSafeX(0),
+	nSafeY(0),
+	nExplosionX(0),
+	nExplosionY(0),
+	nRevealedCells(0),
+	nRevision(0),
+	nMaxCascade(1 << 20),
+	chunks(),
+	workStack()
+{
+	setDensity(density);
+}
+
+void EndlessField::setDensity(const double& density) {
+	dDensity = density;
+	if (density <= 0)
+		nThreshold = 0;
+	else if (density >= 1)
+		nThreshold = ~0ULL;
+	else
+		nThreshold = (uint64_t)(density * 18446744073709551616.0); // density * 2^64
+}
+
+void EndlessField::setSeed(const uint64_t& seed) {
+	nSeed = seed;
+}
+
+void EndlessField::seed() {
+	nSeed = SplitMix::randomSeed();
+}
+
+void EndlessField::resetField() {
+	chunks.clear();
+	workStack.clear();
+	bFirstCell = true;
+	gameState = GameStates::NORMAL;
+	nRevealedCells = 0;
+	nRevision++;
+}
+
+bool EndlessField::isMine(const int64_t& x, const int64_t& y) const {
+	if (!bFirstCell && x >= nSafeX - 1 && x <= nSafeX + 1 && y >= nSafeY - 1 && y <= nSafeY + 1) // Opening around the first cell
+		return false;
+	return (SplitMix(SplitMix(nSeed ^ (uint64_t)x).next() + (uint64_t)y).next() < nThreshold); // First number of a stream per column, then per cell
+}
+
+unsigned char EndlessField::getNumber(const int64_t& x, const int64_t& y) const {
+	unsigned char count = 0;
+	for (int64_t yp = y - 1; yp <= y + 1; yp++) {
+		for (int64_t xp = x - 1; xp <= x + 1; xp++) {
+			if ((xp != x || yp != y) && isMine(xp, yp))
+				count++;
+		}
+	}
+	return count;
+}
+
+unsigned char EndlessField::getCell(const int64_t& x, const int64_t& y) const {
+	if (isMine(x, y)) {
+		if (gameState == GameStates::LOSS && x == nExplosionX && y == nExplosionY)
+			return Minefield::getDefaultTileValue(TileTypes::EXPLOSION);
+		return Minefield::getDefaultTileValue(TileTypes::BOMB);
+	}
+	if (gameState == GameStates::LOSS) {
+		const Chunk* chunk = findChunk(x, y);
+		if (chunk && ((chunk->flagged[y & (nChunkSize - 1)] >> (x & (nChunkSize - 1))) & 1)) // Mis-labeled bomb
+			return Minefield::getDefaultTileValue(TileTypes::MISTAKE);
+	}
+	return getNumber(x, y);
+}
+
+unsigned char EndlessField::getCover(const int64_t& x, const int64_t& y) const {
+	const Chunk* chunk = findChunk(x, y);
+	if (!chunk) // Untouched chunk, every cell is covered
+		return (gameState == GameStates::NORMAL ? 1 : 0);
+	const int row = (int)(y & (nChunkSize - 1));
+	const uint64_t bit = 1ULL << (x & (nChunkSize - 1));
+	if (chunk->revealed[row] & bit)
+		return 0;
+	if (gameState != GameStates::NORMAL) // Everything is shown once the game ends
+		return 0;
+	if (chunk->flagged[row] & bit)
+		return 2;
+	return ((chunk->unknown[row] & bit) ? 3 : 1);
+}
+
+void EndlessField::uncoverCell(const int64_t& x, const int64_t& y) {
+	if (gameState != GameStates::NORMAL)
+		return;
+	if (bFirstCell) { // First cell (and its neighbors) are always safe
+		nSafeX = x;
+		nSafeY = y;
+		bFirstCell = false;
+	}
+	if (isMine(x, y)) { // KABOOM
+		nExplosionX = x;
+		nExplosionY = y;
+		gameState = GameStates::LOSS;
+		workStack.clear();
+		nRevision++;
+		return;
+	}
+	if (reveal(x, y) && getNumber(x, y) == 0) {
+		workStack.push_back(std::make_pair(x, y));
+		continueCascade();
+	}
+}
+
+bool EndlessField::chordCell(const int64_t& x, const int64_t& y) {
+	if (gameState != GameStates::NORMAL || getCover(x, y) != 0)
+		return false;
+	const unsigned char number = getNumber(x, y);
+	if (number == 0)
+		return false;
+	unsigned char nFlags = 0;
+	for (int64_t yp = y - 1; yp <= y + 1; yp++) {
+		for (int64_t xp = x - 1; xp <= x + 1; xp++) {
+			if (getCover(xp, yp) == 2) // Flagged cell
+				nFlags++;
+		}
+	}
+	if (nFlags != number)
+		return false;
+	for (int64_t yp = y - 1; yp <= y + 1; yp++) { // Uncover all neighboring cells
+		for (int64_t xp = x - 1; xp <= x + 1; xp++) {
+			if (getCover(xp, yp) == 1)
+				uncoverCell(xp, yp);
+		}
+	}
+	return true;
+}
+
+void EndlessField::cycleFlag(const int64_t& x, const int64_t& y) {
+	if (gameState != GameStates::NORMAL)
+		return;
+	const unsigned char cover = getCover(x, y);
+	if (cover == 0)
+		return;
+	Chunk& chunk = getChunk(x, y);
+	const int row = (int)(y & (nChunkSize - 1));
+	const uint64_t bit = 1ULL << (x & (nChunkSize - 1));
+	switch (cover) {
+	case 1: // Flag cell
+		chunk.flagged[row] |= bit;
+		break;
+	case 2: // Mark cell as unknown (?)
+		chunk.flagged[row] &= ~bit;
+		chunk.unknown[row] |= bit;
+		break;
+	case 3: // Un-flag cell
+		chunk.unknown[row] &= ~bit;
+		break;
+	default:
+		break;
+	}
+	nRevision++;
+}
+
+void EndlessField::continueCascade() {
+	size_t nRevealed = 0;
+	while (!workStack.empty() && nRevealed < nMaxCascade) {
+		const int64_t x = workStack.back().first;
+		const int64_t y = workStack.back().second;
+		workStack.pop_back();
+		// Reveal the four edge neighbors of a zero (crossing chunk boundaries), the same cells a fixed minefield cascades to
+		const int64_t neighbors[4][2] = { { x - 1, y }, { x + 1, y }, { x, y - 1 }, { x, y + 1 } };
+		for (int i = 0; i < 4; i++) {
+			const int64_t xp = neighbors[i][0];
+			const int64_t yp = neighbors[i][1];
+			if (!reveal(xp, yp))
+				continue;
+			nRevealed++;
+			if (getNumber(xp, yp) == 0)
+				workStack.push_back(std::make_pair(xp, yp));
+		}
+	}
+}
+
+uint64_t EndlessField::getChunkKey(const int64_t& x, const int64_t& y) {
+	// Chunk coordinates (arithmetic shift rounds towards negative infinity)
+	const uint32_t cx = (uint32_t)(x >> nChunkBits);
+	const uint32_t cy = (uint32_t)(y >> nChunkBits);
+	return ((uint64_t)cy << 32) | cx;
+}
+
+const EndlessField::Chunk* EndlessField::findChunk(const int64_t& x, const int64_t& y) const {
+	auto chunk = chunks.find(getChunkKey(x, y));
+	return (chunk != chunks.end() ? &chunk->second : 0x0);
+}
+
+EndlessField::Chunk& EndlessField::getChunk(const int64_t& x, const int64_t& y) {
+	auto chunk = chunks.find(getChunkKey(x, y));
+	if (chunk != chunks.end())
+		return chunk->second;
+	Chunk& newChunk = chunks[getChunkKey(x, y)];
+	std::memset(&newChunk, 0, sizeof(Chunk));
+	return newChunk;
+}
+
+bool EndlessField::reveal(const int64_t& x, const int64_t& y) {
+	Chunk& chunk = getChunk(x, y);
+	const int row = (int)(y & (nChunkSize - 1));
+	const uint64_t bit = 1ULL << (x & (nChunkSize - 1));
+	if (chunk.revealed[row] & bit)
+		return false;
+	chunk.revealed[row] |= bit;
+	chunk.flagged[row] &= ~bit;
+	chunk.unknown[row] &= ~bit;
+	nRevealedCells++;
+	nRevision++;
+	return true;
+}
@@ -0,0 +1,253 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <iomanip>
+
+#include "frametimer.hpp"
+
+FrameTimer::FrameTimer(const size_t& capacity/*=1024*/) :
+	nCapacity(std::max(capacity, (size_t)1)),
+	nWritten(0),
+	nCurrentPhase(-1),
+	startTime(std::chrono::steady_clock::now()),
+	frameStart(startTime),
+	phaseStart(startTime),
+	current(),
+	slots(new Slot[nCapacity])
+{
+	for (size_t i = 0; i < nCapacity; i++) {
+		slots[i].nSequence = 0;
+		for (int j = 0; j < nRecordValues; j++) {
+			slots[i].nValues[j] = 0;
+		}
+	}
+}
+
+std::string FrameTimer::getPhaseName(const FramePhases& phase) {
+	switch (phase) {
+	case FramePhases::INPUT:
+		return "input";
+	case FramePhases::LOGIC:
+		return "logic";
+	case FramePhases::TILES:
+		return "tiles";
+	case FramePhases::RENDER:
+		return "render";
+	default:
+		break;
+	}
+	return "unknown";
+}
+
+void FrameTimer::beginFrame() {
+	frameStart = std::chrono::steady_clock::now();
+	phaseStart = frameStart;
+	nCurrentPhase = -1;
+	current.nFrame = nWritten.load(std::memory_order_relaxed);
+	current.nStart = getElapsed(startTime, frameStart);
+	current.nDuration = 0;
+	current.nInputLatency = 0;
+	current.nSpans = 0;
+	for (int i = 0; i < FrameRecord::nPhases; i++) {
+		current.nPhaseTime[i] = 0;
+	}
+}
+
+void FrameTimer::endFrame() {
+	enterPhase(-1);
+	current.nDuration = getElapsed(frameStart, std::chrono::steady_clock::now());
+
+	// Publish the frame (only the frame loop writes, so the slot is never written concurrently)
+	const uint64_t nFrame = nWritten.load(std::memory_order_relaxed);
+	Slot& slot = slots[nFrame % nCapacity];
+	slot.nSequence.store(2 * nFrame + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	uint64_t values[nRecordValues] = {
+		current.nFrame, current.nStart, current.nDuration,
+		current.nPhaseTime[0], current.nPhaseTime[1], current.nPhaseTime[2], current.nPhaseTime[3],
+		current.nInputLatency, current.nSpans
+	};
+	for (uint64_t i = 0; i < current.nSpans; i++) {
+		values[5 + FrameRecord::nPhases + 2 * i] = current.nSpanStart[i] * FrameRecord::nPhases + current.nSpanPhase[i];
+		values[6 + FrameRecord::nPhases + 2 * i] = current.nSpanTime[i];
+	}
+	for (int i = 0; i < nRecordValues; i++) {
+		slot.nValues[i].store(values[i], std::memory_order_relaxed);
+	}
+	slot.nSequence.store(2 * nFrame + 2, std::memory_order_release);
+	nWritten.store(nFrame + 1, std::memory_order_release);
+}
+
+int FrameTimer::enterPhase(const int& phase) {
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	const int previous = nCurrentPhase;
+	if (previous >= 0) {
+		const uint64_t nStart = getElapsed(frameStart, phaseStart);
+		const uint64_t nTime = getElapsed(phaseStart, now);
+		current.nPhaseTime[previous] += nTime;
+		const uint64_t nLast = current.nSpans - 1;
+		if (current.nSpans > 0 && current.nSpanPhase[nLast] == previous && current.nSpanStart[nLast] + current.nSpanTime[nLast] == nStart) // Phase entered again while it was active
+			current.nSpanTime[nLast] += nTime;
+		else if (nTime > 0 && current.nSpans < FrameRecord::nMaxSpans) {
+			current.nSpanPhase[current.nSpans] = previous;
+			current.nSpanStart[current.nSpans] = nStart;
+			current.nSpanTime[current.nSpans] = nTime;
+			current.nSpans++;
+		}
+	}
+	nCurrentPhase = (phase < FrameRecord::nPhases ? phase : -1);
+	phaseStart = now;
+	return previous;
+}
+
+void FrameTimer::getFrames(std::vector<FrameRecord>& frames) const {
+	frames.clear();
+	const uint64_t nFrames = nWritten.load(std::memory_order_acquire);
+	const uint64_t nFirst = (nFrames > nCapacity ? nFrames - nCapacity : 0);
+	for (uint64_t frame = nFirst; frame < nFrames; frame++) {
+		const Slot& slot = slots[frame % nCapacity];
+		const uint64_t nSequence = slot.nSequence.load(std::memory_order_acquire);
+		if (nSequence != 2 * frame + 2) // Overwritten by a newer frame
+			continue;
+		uint64_t values[nRecordValues];
+		for (int i = 0; i < nRecordValues; i++) {
+			values[i] = slot.nValues[i].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.nSequence.load(std::memory_order_relaxed) != nSequence) // Overwritten while copying
+			continue;
+		FrameRecord record;
+		record.nFrame = values[0];
+		record.nStart = values[1];
+		record.nDuration = values[2];
+		for (int i = 0; i < FrameRecord::nPhases; i++) {
+			record.nPhaseTime[i] = values[3 + i];
+		}
+		record.nInputLatency = values[3 + FrameRecord::nPhases];
+		record.nSpans = std::min(values[4 + FrameRecord::nPhases], (uint64_t)FrameRecord::nMaxSpans);
+		for (uint64_t i = 0; i < record.nSpans; i++) {
+			record.nSpanPhase[i] = (int)(values[5 + FrameRecord::nPhases + 2 * i] % FrameRecord::nPhases);
+			record.nSpanStart[i] = values[5 + FrameRecord::nPhases + 2 * i] / FrameRecord::nPhases;
+			record.nSpanTime[i] = values[6 + FrameRecord::nPhases + 2 * i];
+		}
+		frames.push_back(record);
+	}
+}
+
+PhaseStatistics FrameTimer::getStatistics(const std::vector<FrameRecord>& frames, const int& phase) {
+	std::vector<uint64_t> times;
+	times.reserve(frames.size());
+	for (auto frame = frames.begin(); frame != frames.end(); frame++) {
+		times.push_back(phase < 0 ? frame->nDuration : frame->nPhaseTime[phase]);
+	}
+	return getStatistics(times);
+}
+
+PhaseStatistics FrameTimer::getLatencyStatistics(const std::vector<FrameRecord>& frames) {
+	std::vector<uint64_t> times;
+	for (auto frame = frames.begin(); frame != frames.end(); frame++) {
+		if (frame->nInputLatency > 0)
+			times.push_back(frame->nInputLatency);
+	}
+	return getStatistics(times);
+}
+
+void FrameTimer::print() const {
+	std::vector<FrameRecord> frames;
+	getFrames(frames);
+	std::cout << " Frame times (last " << frames.size() << " frames, ms):" << std::endl;
+	for (int phase = -1; phase < FrameRecord::nPhases; phase++) {
+		const PhaseStatistics stats = getStatistics(frames, phase);
+		std::cout << "  " << (phase < 0 ? std::string("frame") : getPhaseName((FramePhases)phase)) << ": p50=" << stats.dMedian;
+		std::cout << ", p99=" << stats.dPercentile99 << ", max=" << stats.dMax << ", mean=" << stats.dMean << std::endl;
+	}
+	const PhaseStatistics latency = getLatencyStatistics(frames);
+	if (latency.nFrames > 0) {
+		std::cout << "  click to frame (" << latency.nFrames << " clicks): p50=" << latency.dMedian;
+		std::cout << ", p99=" << latency.dPercentile99 << ", max=" << latency.dMax << ", mean=" << latency.dMean << std::endl;
+	}
+}
+
+bool FrameTimer::write(const std::string& fname) const {
+	std::vector<FrameRecord> frames;
+	getFrames(frames);
+	const std::string extension = ".json";
+	const bool bTrace = (fname.size() >= extension.size() && fname.compare(fname.size() - extension.size(), extension.size(), extension) == 0);
+	const bool bSuccess = (bTrace ? writeTrace(fname, frames) : writeCsv(fname, frames));
+	if (!bSuccess)
+		std::cout << " Error! Failed to write frame times to file (" << fname << ")." << std::endl;
+	return bSuccess;
+}
+
+PhaseStatistics FrameTimer::getStatistics(std::vector<uint64_t>& times) {
+	PhaseStatistics stats = { times.size(), 0, 0, 0, 0 };
+	if (times.empty())
+		return stats;
+	double dTotal = 0;
+	for (auto time = times.begin(); time != times.end(); time++) {
+		dTotal += *time;
+	}
+	std::sort(times.begin(), times.end());
+	stats.dMean = dTotal / times.size() / 1E6;
+	stats.dMedian = times[(times.size() - 1) / 2] / 1E6;
+	stats.dPercentile99 = times[(times.size() - 1) * 99 / 100] / 1E6;
+	stats.dMax = times.back() / 1E6;
+	return stats;
+}
+
+uint64_t FrameTimer::getElapsed(const std::chrono::steady_clock::time_point& since, const std::chrono::steady_clock::time_point& now) const {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - since).count();
+}
+
+bool FrameTimer::writeCsv(const std::string& fname, const std::vector<FrameRecord>& frames) const {
+	std::ofstream ofile(fname.c_str());
+	if (!ofile.good())
+		return false;
+	ofile << std::fixed << std::setprecision(6);
+	ofile << "frame,start_ms,frame_ms";
+	for (int phase = 0; phase < FrameRecord::nPhases; phase++) {
+		ofile << "," << getPhaseName((FramePhases)phase) << "_ms";
+	}
+	ofile << ",input_latency_ms" << std::endl;
+	for (auto frame = frames.begin(); frame != frames.end(); frame++) {
+		ofile << frame->nFrame << "," << frame->nStart / 1E6 << "," << frame->nDuration / 1E6;
+		for (int phase = 0; phase < FrameRecord::nPhases; phase++) {
+			ofile << "," << frame->nPhaseTime[phase] / 1E6;
+		}
+		ofile << "," << frame->nInputLatency / 1E6 << std::endl;
+	}
+	return ofile.good();
+}
+
+bool FrameTimer::writeTrace(const std::string& fname, const std::vector<FrameRecord>& frames) const {
+	std::ofstream ofile(fname.c_str());
+	if (!ofile.good())
+		return false;
+
+	ofile << std::fixed << std::setprecision(3); // Microseconds
+
+	// Each phase is drawn as its own track, with one event for every span of time spent in it
+	ofile << "{\"traceEvents\":[" << std::endl;
+	ofile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"frame\"}}";
+	for (int phase = 0; phase < FrameRecord::nPhases; phase++) {
+		ofile << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << phase + 1;
+		ofile << ",\"args\":{\"name\":\"" << getPhaseName((FramePhases)phase) << "\"}}";
+	}
+	ofile << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << FrameRecord::nPhases + 1;
+	ofile << ",\"args\":{\"name\":\"input latency\"}}";
+	for (auto frame = frames.begin(); frame != frames.end(); frame++) {
+		ofile << "," << std::endl << "{\"name\":\"frame " << frame->nFrame << "\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":" << frame->nStart / 1E3;
+		ofile << ",\"dur\":" << frame->nDuration / 1E3 << "}";
+		for (uint64_t i = 0; i < frame->nSpans; i++) { // Each span of time spent in a phase
+			const int phase = frame->nSpanPhase[i];
+			ofile << "," << std::endl << "{\"name\":\"" << getPhaseName((FramePhases)phase) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << phase + 1;
+			ofile << ",\"ts\":" << (frame->nStart + frame->nSpanStart[i]) / 1E3 << ",\"dur\":" << frame->nSpanTime[i] / 1E3 << "}";
+		}
+		if (frame->nInputLatency > 0 && frame->nInputLatency <= frame->nStart + frame->nDuration) { // Ends with the frame
+			ofile << "," << std::endl << "{\"name\":\"click\",\"ph\":\"X\",\"pid\":1,\"tid\":" << FrameRecord::nPhases + 1;
+			ofile << ",\"ts\":" << (frame->nStart + frame->nDuration - frame->nInputLatency) / 1E3 << ",\"dur\":" << frame->nInputLatency / 1E3 << "}";
+		}
+	}
+	ofile << std::endl << "]}" << std::endl;
+	return ofile.good();
+}
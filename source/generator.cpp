@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <chrono>
+
+#include "generator.hpp"
+#include "minefield.hpp"
+#include "solver.hpp"
+#include "splitmix.hpp"
+
+namespace {
+
+// Reveal every cell proven safe until the solver gets stuck, return true if the board was cleared
+bool solveWithoutGuessing(Minefield& field, Solver& solver, const int& firstCell) {
+	field.uncoverCell(firstCell);
+	solver.update(field);
+	field.clearChanges();
+	std::vector<int> safeCells;
+	while (field.getState() == GameStates::NORMAL) {
+		if (solver.getSafeCells().empty()) // A guess is required
+			return false;
+		safeCells = solver.getSafeCells().get();
+		for (auto cell = safeCells.begin(); cell != safeCells.end(); cell++) {
+			if (field.getCover(*cell) != 0) // May have been uncovered by a cascade
+				field.uncoverCell(*cell);
+		}
+		solver.update(field);
+		field.clearChanges();
+	}
+	return (field.getState() == GameStates::WIN);
+}
+
+} // namespace
+
+bool BoardKey::operator<(const BoardKey& rhs) const {
+	if (nWidth != rhs.nWidth)
+		return (nWidth < rhs.nWidth);
+	if (nHeight != rhs.nHeight)
+		return (nHeight < rhs.nHeight);
+	if (nMines != rhs.nMines)
+		return (nMines < rhs.nMines);
+	return (nRegion < rhs.nRegion);
+}
+
+BoardGenerator::BoardGenerator(const unsigned int& nThreads/*=0*/) :
+	bStop(false),
+	bActive(false),
+	bFailed(false),
+	nPoolSize(4),
+	nMaxAttempts(1000000),
+	nBoardsGenerated(0),
+	nAttempts(0),
+	nGenerationTime(0),
+	nWidth(0),
+	nHeight(0),
+	nMines(0),
+	nThreads(nThreads),
+	lock(),
+	nSeed(SplitMix::randomSeed()),
+	pool(),
+	pools()
+{
+}
+
+BoardGenerator::~BoardGenerator() {
+	stop();
+}
+
+void BoardGenerator::setSeed(const uint64_t& seed) {
+	stop();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		nSeed = seed;
+		pools.clear();
+	}
+	bStop = false;
+	bFailed = false;
+	startRefill(); // Refill the pool of the prepared minefield size (if any)
+}
+
+double BoardGenerator::getGenerationTime() const {
+	return nGenerationTime / 1E6;
+}
+
+int BoardGenerator::getRegion(const int& width, const int& cell) {
+	const int nRegionsX = (width + nRegionSize - 1) / nRegionSize;
+	return ((cell / width) / nRegionSize) * nRegionsX + (cell % width) / nRegionSize;
+}
+
+int BoardGenerator::getRegionCenter(const int& width, const int& height, const int& region) {
+	const int nRegionsX = (width + nRegionSize - 1) / nRegionSize;
+	const int x = std::min(width - 1, (region % nRegionsX) * nRegionSize + nRegionSize / 2);
+	const int y = std::min(height - 1, (region / nRegionsX) * nRegionSize + nRegionSize / 2);
+	return y * width + x;
+}
+
+void BoardGenerator::prepare(const int& width, const int& height, const int& mines) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		nWidth = width;
+		nHeight = height;
+		nMines = mines;
+	}
+	bStop = false;
+	bFailed = false;
+	if (!pool) // Start worker threads
+		pool.reset(new ThreadPool(nThreads));
+	startRefill();
+}
+
+void BoardGenerator::stop() {
+	bStop = true;
+	if (pool)
+		pool->wait();
+}
+
+bool BoardGenerator::getBoard(const int& width, const int& height, const int& mines, const int& cell, std::vector<int>& layout) {
+	BoardKey key = { width, height, mines, getRegion(width, cell) };
+	unsigned long long board = 0;
+	bool bFound = false;
+	bool bPrepared = false;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		RegionPool& region = pools[key];
+		board = region.nNext++;
+		region.nQueued = std::max(region.nQueued, region.nNext); // A board still being generated is no longer needed
+		auto ready = region.boards.find(board);
+		if (ready != region.boards.end()) {
+			layout.swap(ready->second);
+			region.boards.erase(ready);
+			bFound = true;
+		}
+		bPrepared = (width == nWidth && height == nHeight && mines == nMines);
+	}
+	if (bPrepared) // Replace the board we just took
+		startRefill();
+	if (bFound)
+		return true;
+	return generate(key, getBoardSeed(key, board), layout, nMaxAttempts);
+}
+
+bool BoardGenerator::generate(const BoardKey& key, const uint64_t& seed, std::vector<int>& layout, const unsigned long long& maxAttempts) {
+	auto startTime = std::chrono::steady_clock::now();
+	const int nCells = key.nWidth * key.nHeight;
+	const int firstCell = getRegionCenter(key.nWidth, key.nHeight, key.nRegion);
+
+	// Cells allowed to contain a mine (everything except the first region and its neighbors)
+	const int nRegionsX = (key.nWidth + nRegionSize - 1) / nRegionSize;
+	const int x0 = (key.nRegion % nRegionsX) * nRegionSize - 1;
+	const int y0 = (key.nRegion / nRegionsX) * nRegionSize - 1;
+	std::vector<int> allowedCells;
+	for (int i = 0; i < nCells; i++) {
+		const int x = i % key.nWidth;
+		const int y = i / key.nWidth;
+		if (x < x0 || x > x0 + nRegionSize + 1 || y < y0 || y > y0 + nRegionSize + 1)
+			allowedCells.push_back(i);
+	}
+	if ((int)allowedCells.size() < key.nMines)
+		return false;
+
+	Minefield field(key.nWidth, key.nHeight, key.nMines);
+	Solver solver;
+	SplitMix random(seed);
+	std::vector<unsigned char> selected(allowedCells.size(), 0);
+	std::vector<int> picks;
+	bool bSolvable = false;
+	unsigned long long attempt = 0;
+	for (; attempt < maxAttempts && !bSolvable && !bStop; attempt++) {
+		// Floyd's sampling from the allowed cells
+		const int nAllowed = (int)allowedCells.size();
+		picks.clear();
+		for (int j = nAllowed - key.nMines; j < nAllowed; j++) {
+			int pick = random.next(j + 1);
+			if (selected[pick])
+				pick = j;
+			selected[pick] = 1;
+			picks.push_back(pick);
+		}
+		layout.clear();
+		for (auto pick = picks.begin(); pick != picks.end(); pick++) {
+			layout.push_back(allowedCells[*pick]);
+			selected[*pick] = 0;
+		}
+		field.resetField();
+		field.setMines(layout);
+		bSolvable = solveWithoutGuessing(field, solver, firstCell);
+	}
+	nAttempts += attempt;
+	nGenerationTime += (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+	if (bSolvable)
+		nBoardsGenerated++;
+	return bSolvable;
+}
+
+uint64_t BoardGenerator::getBoardSeed(const BoardKey& key, const unsigned long long& board) const {
+	const uint64_t streams[5] = { (uint64_t)key.nWidth, (uint64_t)key.nHeight, (uint64_t)key.nMines, (uint64_t)key.nRegion, board };
+	uint64_t seed = nSeed;
+	for (int i = 0; i < 5; i++) {
+		seed = SplitMix::split(seed, streams[i]);
+	}
+	return seed;
+}
+
+bool BoardGenerator::findEmptyRegion(BoardKey& key, unsigned long long* board/*=0x0*/) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (nWidth <= 0 || nHeight <= 0)
+		return false;
+	const int nRegionsX = (nWidth + nRegionSize - 1) / nRegionSize;
+	const int nRegionsY = (nHeight + nRegionSize - 1) / nRegionSize;
+	size_t nFewest = nPoolSize;
+	for (int region = 0; region < nRegionsX * nRegionsY; region++) { // Find the region with the fewest boards (ready or being generated)
+		BoardKey candidate = { nWidth, nHeight, nMines, region };
+		const RegionPool& regionPool = pools[candidate];
+		const size_t nBoards = (size_t)(regionPool.nQueued - regionPool.nNext);
+		if (nBoards < nFewest) {
+			nFewest = nBoards;
+			key = candidate;
+		}
+	}
+	if (nFewest >= nPoolSize)
+		return false;
+	if (board)
+		*board = pools[key].nQueued++;
+	return true;
+}
+
+void BoardGenerator::refill() {
+	BoardKey key;
+	unsigned long long board = 0;
+	std::vector<int> layout;
+	while (!bStop && !bFailed && findEmptyRegion(key, &board)) {
+		if (!generate(key, getBoardSeed(key, board), layout, nMaxAttempts)) { // Too dense to find a solvable board
+			bFailed = true;
+			return;
+		}
+		std::lock_guard<std::mutex> guard(lock);
+		RegionPool& region = pools[key];
+		if (board >= region.nNext) // Otherwise it was already handed out (and generated by getBoard)
+			region.boards[board].swap(layout);
+	}
+}
+
+void BoardGenerator::startRefill() {
+	bool bExpected = false;
+	if (!pool || bFailed || !bActive.compare_exchange_strong(bExpected, true)) // Already refilling
+		return;
+	auto nRunning = std::make_shared<std::atomic<size_t> >(pool->getThreadCount());
+	for (size_t i = 0; i < pool->getThreadCount(); i++) {
+		pool->push([this, nRunning]() {
+			refill();
+			if (--(*nRunning) == 0) {
+				bActive = false;
+				BoardKey key;
+				if (!bStop && !bFailed && findEmptyRegion(key)) // A board was taken after this task finished checking
+					startRefill();
+			}
+		});
+	}
+}
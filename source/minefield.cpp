@@ -0,0 +1,845 @@
+#include <iostream>
+#include <algorithm>
+
+#include "minefield.hpp"
+
+Minefield::Minefield() :
+	Minefield(10, 10, 10)
+{
+}
+
+Minefield::Minefield(const int& width, const int& height, const int& bombs) :
+	nSeed(0),
+	nBoards(0),
+	bFirstCell(true),
+	bFullUpdate(true),
+	nSizeX(0),
+	nSizeY(0),
+	nBombs(0),
+	nRemainingCells(0),
+	nMaxChanges(0),
+	gameState(GameStates::NORMAL),
+	topology(Topologies::SQUARE),
+	grid(),
+	minefield(),
+	mines(),
+	covered(),
+	flagged(),
+	unknown(),
+	blank(),
+	chordNeighbors(),
+	changedCells(),
+	fillStack(),
+	fillCells(),
+	bHistory(false),
+	nMoveDepth(0),
+	nHistoryPosition(0),
+	moveHistory(),
+	historyWords(),
+	historyMasks(),
+	historyTiles(),
+	touchedWords(),
+	gridMap()
+{
+	// Setup tile map
+	const TileTypes types[15] = {
+		TileTypes::ZERO, TileTypes::ONE, TileTypes::TWO, TileTypes::THREE, TileTypes::FOUR,
+		TileTypes::FIVE, TileTypes::SIX, TileTypes::SEVEN, TileTypes::EIGHT, TileTypes::BOMB,
+		TileTypes::EXPLOSION, TileTypes::MISTAKE, TileTypes::NORMAL, TileTypes::FLAGGED, TileTypes::UNKNOWN
+	};
+	for (int i = 0; i < 15; i++) {
+		gridMap[types[i]] = getDefaultTileValue(types[i]);
+	}
+
+	// Reverse lookup of tile values
+	std::fill(typeMap, typeMap + 256, TileTypes::NONE);
+	for (auto type = gridMap.begin(); type != gridMap.end(); type++) {
+		typeMap[type->second] = type->first;
+	}
+	setSize(width, height, bombs);
+}
+
+bool Minefield::getDifficulty(const unsigned int& level, int& width, int& height, int& bombs) {
+	const int diffX[9] = { 10, 9, 8, 16, 16, 15, 15, 15, 30 };
+	const int diffY[9] = { 10, 9, 8, 16, 15, 15, 14, 13, 16 };
+	const int diffB[9] = { 10, 10, 10, 40, 40, 40, 40, 40, 99 };
+	if (level >= 9)
+		return false;
+	width = diffX[level];
+	height = diffY[level];
+	bombs = diffB[level];
+	return true;
+}
+
+unsigned char Minefield::getDefaultTileValue(const TileTypes& type) {
+	switch (type) {
+	case TileTypes::ZERO: return 0;
+	case TileTypes::ONE: return 1;
+	case TileTypes::TWO: return 2;
+	case TileTypes::THREE: return 3;
+	case TileTypes::FOUR: return 4;
+	case TileTypes::FIVE: return 5;
+	case TileTypes::SIX: return 6;
+	case TileTypes::SEVEN: return 7;
+	case TileTypes::EIGHT: return 8;
+	case TileTypes::BOMB: return 9;
+	case TileTypes::EXPLOSION: return 10;
+	case TileTypes::MISTAKE: return 11;
+	case TileTypes::NORMAL: return 12;
+	case TileTypes::FLAGGED: return 13;
+	case TileTypes::UNKNOWN: return 14;
+	default:
+		break;
+	}
+	return 0;
+}
+
+unsigned char Minefield::getTileValue(const TileTypes& type) const {
+	auto entry = gridMap.find(type);
+	return (entry != gridMap.end() ? entry->second : 0);
+}
+
+void Minefield::setSize(const int& width, const int& height, const int& bombs) {
+	nSizeX = width;
+	nSizeY = height;
+	nBombs = bombs;
+	nMaxChanges = std::max(64, nSizeX * nSizeY / 4);
+	changedCells.reserve(nMaxChanges); // Changes never need to be allocated while playing
+	fillStack.reserve(4 * (nSizeX + nSizeY));
+	chordNeighbors.reserve(nMaxTopologyNeighbors + 1);
+	grid.nSizeX = nSizeX;
+	grid.nSizeY = nSizeY;
+	if (topology != Topologies::SQUARE && !setTopology(topology, grid.nLayerRows)) // No longer fits the new size
+		setTopology(Topologies::SQUARE);
+	minefield = std::vector<unsigned char>(nSizeY * nSizeX, 0);
+	mines.resize(nSizeX, nSizeY);
+	covered.resize(nSizeX, nSizeY);
+	flagged.resize(nSizeX, nSizeY);
+	unknown.resize(nSizeX, nSizeY);
+	blank.resize(nSizeX, nSizeY);
+	if (bHistory)
+		allocateHistory();
+	resetField();
+}
+
+bool Minefield::setTopology(const Topologies& type, const int& layerRows/*=0*/) {
+	if (type == Topologies::TORUS && (nSizeX < 3 || nSizeY < 3)) {
+		std::cout << " Error! Toroidal minefields must be at least 3 x 3." << std::endl;
+		return false;
+	}
+	if (type == Topologies::CUBIC && (layerRows <= 0 || nSizeY % layerRows != 0)) {
+		std::cout << " Error! Cubic minefield height (" << nSizeY << ") is not a whole number of layers of " << layerRows << " rows." << std::endl;
+		return false;
+	}
+	topology = type;
+	grid.nLayerRows = (type == Topologies::CUBIC ? layerRows : nSizeY);
+	resetField();
+	return true;
+}
+
+void Minefield::setSeed(const uint64_t& seed) {
+	nSeed = seed;
+	nBoards = 0;
+}
+
+void Minefield::seed() {
+	setSeed(SplitMix::randomSeed());
+}
+
+void Minefield::resetField() {
+	std::fill(minefield.begin(), minefield.end(), 0);
+	mines.clear();
+	covered.fill();
+	flagged.clear();
+	unknown.clear();
+	nRemainingCells = nSizeX * nSizeY - nBombs;
+	gameState = GameStates::NORMAL;
+	bFirstCell = true;
+	bFullUpdate = true;
+	changedCells.clear();
+	clearHistory();
+}
+
+bool Minefield::setMines(const std::vector<int>& cells) {
+	if (!bFirstCell || (int)cells.size() != nBombs)
+		return false;
+	mines.clear();
+	for (auto cell = cells.begin(); cell != cells.end(); cell++) {
+		mines.set(*cell % nSizeX, *cell / nSizeX);
+	}
+	countNumbers();
+	bFirstCell = false;
+	return true;
+}
+
+void Minefield::saveMines(uint64_t* words) const {
+	mines.copyTo(words);
+}
+
+bool Minefield::loadMines(const uint64_t* words) {
+	if (!bFirstCell)
+		return false;
+	const int nRowWords = mines.getRowWords();
+	const uint64_t nPadding = ((nSizeX & 63) != 0 ? ~0ULL << (nSizeX & 63) : 0); // Bits past the end of a row
+	long long nCount = 0;
+	for (int y = 0; y < nSizeY; y++) {
+		const uint64_t* row = words + (size_t)y * nRowWords;
+		if (nRowWords > 0 && (row[nRowWords - 1] & nPadding) != 0)
+			return false;
+		for (int w = 0; w < nRowWords; w++) {
+			nCount += BitPlane::countBits(row[w]);
+		}
+	}
+	if (nCount != nBombs)
+		return false;
+	mines.copyFrom(words);
+	countNumbers();
+	bFirstCell = false;
+	return true;
+}
+
+void Minefield::clearChanges() {
+	changedCells.clear();
+	bFullUpdate = false;
+}
+
+void Minefield::saveState(uint64_t* words) const {
+	const size_t nPlaneWords = (size_t)nSizeY * covered.getRowWords();
+	covered.copyTo(words);
+	flagged.copyTo(words + nPlaneWords);
+	unknown.copyTo(words + 2 * nPlaneWords);
+}
+
+bool Minefield::loadState(const uint64_t* words) {
+	if (bFirstCell)
+		return false;
+	const size_t nPlaneWords = (size_t)nSizeY * covered.getRowWords();
+	covered.copyFrom(words);
+	flagged.copyFrom(words + nPlaneWords);
+	unknown.copyFrom(words + 2 * nPlaneWords);
+
+	// Count covered cells which are not mines
+	nRemainingCells = 0;
+	for (int y = 0; y < nSizeY; y++) { // Over all rows
+		const uint64_t* coveredRow = covered.getRow(y);
+		const uint64_t* mineRow = mines.getRow(y);
+		for (int w = 0; w < covered.getRowWords(); w++) {
+			nRemainingCells += BitPlane::countBits(coveredRow[w] & ~mineRow[w]);
+		}
+	}
+	gameState = GameStates::NORMAL;
+	bFullUpdate = true;
+	changedCells.clear();
+	clearHistory();
+	return true;
+}
+
+void Minefield::setTileType(const int& x, const int& y, const TileTypes& type) {
+	saveTile(y * nSizeX + x, gridMap[type]);
+	minefield[y * nSizeX + x] = gridMap[type];
+}
+
+void Minefield::setTileType(const int& index, const TileTypes& type) {
+	saveTile(index, gridMap[type]);
+	minefield[index] = gridMap[type];
+}
+
+TileTypes Minefield::getTileType(const int& x, const int& y) const {
+	return getTileType(y * nSizeX + x);
+}
+
+TileTypes Minefield::getTileType(const int& index) const {
+	return typeMap[minefield[index]];
+}
+
+void Minefield::placeBombs(const int& safeCell) {
+	// Clear minefield
+	mines.clear();
+
+	// Randomly place bombs using Floyd's sampling without replacement, which takes time
+	// proportional to the number of bombs. Samples are drawn from all cells except safeCell.
+	SplitMix random(SplitMix::split(nSeed, nBoards++));
+	const int maxCells = nSizeX * nSizeY - 1;
+	const int maxBombs = std::min(nBombs, maxCells);
+	for (int j = maxCells - maxBombs; j < maxCells; j++) {
+		int cell = random.next(j + 1);
+		if (cell >= safeCell)
+			cell++;
+		if (mines.get(cell % nSizeX, cell / nSizeX)) { // Already selected, take the newest candidate instead
+			cell = (j >= safeCell ? j + 1 : j);
+		}
+		mines.set(cell % nSizeX, cell / nSizeX);
+	}
+
+	// Count all cell neighbors
+	countNumbers();
+	bFirstCell = false;
+}
+
+template <class Topology>
+void Minefield::findBlankCells() {
+	blank.clear();
+	for (int y = 0; y < nSizeY; y++) { // Over all rows
+		for (int x = 0; x < nSizeX; x++) { // Mines have their own tile value, so only blank cells are zero
+			if (minefield[y * nSizeX + x] == 0)
+				blank.set(x, y);
+		}
+	}
+}
+
+template <>
+void Minefield::findBlankCells<SquareTopology>() {
+	// A cell is blank if no mine is within one cell of it, so spread every mine over its neighbors 64 cells at a time
+	const int nWords = blank.getRowWords();
+	for (int y = 0; y < nSizeY; y++) { // Over all rows
+		const uint64_t* above = mines.getRow(y - 1);
+		const uint64_t* row = mines.getRow(y);
+		const uint64_t* below = mines.getRow(y + 1);
+		uint64_t* blankRow = blank.getRow(y);
+		uint64_t previous = 0;
+		uint64_t current = above[0] | row[0] | below[0];
+		for (int w = 0; w < nWords; w++) {
+			const uint64_t next = above[w + 1] | row[w + 1] | below[w + 1]; // Padding word past the last one is zero
+			const uint64_t near = current | (current << 1) | (previous >> 63) | (current >> 1) | (next << 63);
+			const int nBits = nSizeX - 64 * w;
+			blankRow[w] = ~near & (nBits >= 64 ? ~0ULL : (1ULL << nBits) - 1);
+			previous = current;
+			current = next;
+		}
+	}
+}
+
+template <class Topology>
+void Minefield::scatterNumbers() {
+	const unsigned char bomb = gridMap[TileTypes::BOMB];
+	int neighbors[Topology::nMaxNeighbors];
+	std::fill(minefield.begin(), minefield.end(), 0);
+	for (int y = 0; y < nSizeY; y++) { // Over all rows
+		const uint64_t* row = mines.getRow(y);
+		for (int w = 0; w < mines.getRowWords(); w++) { // Over all bombs in the row
+			for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+				const int nNeighbors = Topology::getNeighbors(grid, 64 * w + BitPlane::lowestBit(bits), y, neighbors);
+				for (int i = 0; i < nNeighbors; i++) {
+					minefield[neighbors[i]]++;
+				}
+			}
+		}
+	}
+	for (int y = 0; y < nSizeY; y++) { // Overwrite the (meaningless) count of every bomb
+		const uint64_t* row = mines.getRow(y);
+		for (int w = 0; w < mines.getRowWords(); w++) {
+			for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+				minefield[y * nSizeX + 64 * w + BitPlane::lowestBit(bits)] = bomb;
+			}
+		}
+	}
+}
+
+template <class Topology>
+void Minefield::countNumbers() {
+	scatterNumbers<Topology>();
+	findBlankCells<Topology>();
+}
+
+template <>
+void Minefield::countNumbers<SquareTopology>() {
+	if (64 * (long long)nBombs < nSizeX * nSizeY) { // Sparse minefield, add one around each bomb
+		scatterNumbers<SquareTopology>();
+	}
+	else { // Dense minefield, count neighbors of every cell
+		mines.countNeighbors(minefield, gridMap[TileTypes::BOMB]);
+	}
+	findBlankCells<SquareTopology>();
+}
+
+void Minefield::countNumbers() {
+	switch (topology) {
+	case Topologies::TORUS:
+		countNumbers<TorusTopology>();
+		break;
+	case Topologies::HEX:
+		countNumbers<HexTopology>();
+		break;
+	case Topologies::CUBIC:
+		countNumbers<CubicTopology>();
+		break;
+	default:
+		countNumbers<SquareTopology>();
+		break;
+	}
+}
+
+void Minefield::endGame(bool bWin) {
+	if (bWin) { // Win
+		for (int y = 0; y < nSizeY; y++) { // Over all rows
+			for (int x = 0; x < nSizeX; x++) { // Over all columns
+				if (mines.get(x, y)) // Bomb
+					setTileType(x, y, TileTypes::FLAGGED);
+			}
+		}
+		gameState = GameStates::WIN;
+	}
+	else { // Loss
+		for (int y = 0; y < nSizeY; y++) { // Over all rows
+			for (int x = 0; x < nSizeX; x++) { // Over all columns
+				if (!mines.get(x, y) && covered.get(x, y) && flagged.get(x, y)) // Mis-labeled bomb
+					setTileType(x, y, TileTypes::MISTAKE);
+			}
+		}
+		gameState = GameStates::LOSS;
+	}
+	for (int y = 0; y < nSizeY; y++) { // Every cell is uncovered
+		for (int w = 0; w < covered.getRowWords(); w++) {
+			saveWord(y, w);
+		}
+	}
+	covered.clear();
+	flagged.clear();
+	unknown.clear();
+	bFullUpdate = true;
+	changedCells.clear();
+}
+
+template <class Topology>
+void Minefield::fillArea(const int& startX, const int& startY) {
+	// Depth first fill: the fill neighbors of a blank cell are uncovered, and the covered blank ones are searched next
+	int neighbors[Topology::nMaxFillNeighbors];
+	int nUncovered = 0;
+	fillCells.clear();
+	if (covered.get(startX, startY)) {
+		uncover(startX, startY);
+		nUncovered++;
+		fillCells.push_back(startY * nSizeX + startX);
+	}
+	while (!fillCells.empty()) {
+		const int cell = fillCells.back();
+		fillCells.pop_back();
+		const int nNeighbors = Topology::getFillNeighbors(grid, cell % nSizeX, cell / nSizeX, neighbors);
+		for (int i = 0; i < nNeighbors; i++) {
+			const int x = neighbors[i] % nSizeX;
+			const int y = neighbors[i] / nSizeX;
+			if (!covered.get(x, y))
+				continue;
+			uncover(x, y);
+			nUncovered++;
+			if (blank.get(x, y))
+				fillCells.push_back(neighbors[i]);
+		}
+	}
+	nRemainingCells -= nUncovered;
+	if (nRemainingCells == 0) {
+		endGame(true);
+	}
+}
+
+template <>
+void Minefield::fillArea<SquareTopology>(const int& startX, const int& startY) {
+	// Scanline fill: each run of covered blank cells in a row is uncovered at once along with the numbered
+	// cells at either end, and the segments of the rows above and below it are queued to be searched for
+	// more runs. Runs are found 64 cells at a time using the covered and blank planes, and the remaining
+	// cell count is updated once at the end. Nothing is allocated once the stack fits the largest cascade.
+	int nUncovered = 0;
+	int x1 = 0;
+	const FillSegment first = { startY, startX, startX, 0 };
+	fillStack.clear();
+	nUncovered += uncoverBlankRun(startX, startY, first, x1);
+	while (!fillStack.empty()) {
+		const FillSegment segment = fillStack.back();
+		fillStack.pop_back();
+		if (segment.y < 0 || segment.y >= nSizeY)
+			continue;
+
+		// Every covered cell of the segment is next to an uncovered blank cell
+		nUncovered += uncoverRun(segment.y, segment.x0, segment.x1, true);
+
+		// Blank cells start new runs
+		const uint64_t* coveredRow = covered.getRow(segment.y);
+		const uint64_t* blankRow = blank.getRow(segment.y);
+		int x = segment.x0;
+		while (x <= segment.x1) {
+			int w = x >> 6;
+			uint64_t bits = coveredRow[w] & blankRow[w] & (~0ULL << (x & 63));
+			while (bits == 0 && 64 * (w + 1) <= segment.x1) {
+				w++;
+				bits = coveredRow[w] & blankRow[w];
+			}
+			if (bits == 0)
+				break;
+			x = 64 * w + BitPlane::lowestBit(bits);
+			if (x > segment.x1)
+				break;
+			nUncovered += uncoverBlankRun(x, segment.y, segment, x1);
+			x = x1 + 2;
+		}
+	}
+	nRemainingCells -= nUncovered;
+	if (nRemainingCells == 0) {
+		endGame(true);
+	}
+}
+
+int Minefield::uncoverBlankRun(const int& x, const int& y, const FillSegment& parent, int& x1) {
+	const uint64_t* coveredRow = covered.getRow(y);
+	const uint64_t* blankRow = blank.getRow(y);
+	int w = x >> 6;
+	uint64_t bits = ~(coveredRow[w] & blankRow[w]) & ((1ULL << (x & 63)) - 1);
+	while (bits == 0) {
+		w--;
+		bits = ~(coveredRow[w] & blankRow[w]);
+	}
+	const int x0 = 64 * w + BitPlane::highestBit(bits) + 1;
+	w = x >> 6;
+	bits = ~(coveredRow[w] & blankRow[w]) & (~1ULL << (x & 63));
+	while (bits == 0) {
+		w++;
+		bits = ~(coveredRow[w] & blankRow[w]);
+	}
+	x1 = 64 * w + BitPlane::lowestBit(bits) - 1;
+	const int nUncovered = uncoverRun(y, std::max(0, x0 - 1), std::min(nSizeX - 1, x1 + 1));
+	if (parent.dy == 0) { // First run, search both directions
+		const FillSegment up = { y - 1, x0, x1, -1 };
+		const FillSegment down = { y + 1, x0, x1, 1 };
+		fillStack.push_back(up);
+		fillStack.push_back(down);
+		return nUncovered;
+	}
+	const FillSegment next = { y + parent.dy, x0, x1, parent.dy };
+	fillStack.push_back(next);
+	if (x0 < parent.x0) { // Parts of the run past either end of the parent segment
+		const FillSegment back = { y - parent.dy, x0, parent.x0 - 1, -parent.dy };
+		fillStack.push_back(back);
+	}
+	if (x1 > parent.x1) {
+		const FillSegment back = { y - parent.dy, parent.x1 + 1, x1, -parent.dy };
+		fillStack.push_back(back);
+	}
+	return nUncovered;
+}
+
+void Minefield::fillArea(const int& index) {
+	switch (topology) {
+	case Topologies::TORUS:
+		fillArea<TorusTopology>(index % nSizeX, index / nSizeX);
+		break;
+	case Topologies::HEX:
+		fillArea<HexTopology>(index % nSizeX, index / nSizeX);
+		break;
+	case Topologies::CUBIC:
+		fillArea<CubicTopology>(index % nSizeX, index / nSizeX);
+		break;
+	default:
+		fillArea<SquareTopology>(index % nSizeX, index / nSizeX);
+		break;
+	}
+}
+
+void Minefield::uncover(const int& x, const int& y) {
+	if (!covered.get(x, y))
+		return;
+	saveWord(y, x >> 6);
+	covered.reset(x, y);
+	flagged.reset(x, y);
+	unknown.reset(x, y);
+	markChanged(y * nSizeX + x);
+}
+
+int Minefield::uncoverRun(const int& y, const int& x0, const int& x1, const bool& bSkipBlank/*=false*/) {
+	uint64_t* coveredRow = covered.getRow(y);
+	const uint64_t* blankRow = blank.getRow(y);
+	uint64_t* flaggedRow = flagged.getRow(y);
+	uint64_t* unknownRow = unknown.getRow(y);
+	int nUncovered = 0;
+	for (int w = x0 >> 6; w <= (x1 >> 6); w++) {
+		const int low = std::max(x0 - 64 * w, 0);
+		const int high = std::min(x1 - 64 * w, 63);
+		const uint64_t mask = (~0ULL >> (63 - high)) & (~0ULL << low) & (bSkipBlank ? ~blankRow[w] : ~0ULL);
+		const uint64_t bits = coveredRow[w] & mask;
+		if (bits == 0)
+			continue;
+		saveWord(y, w);
+		const int nBits = BitPlane::countBits(bits);
+		nUncovered += nBits;
+		if (!bFullUpdate && (int)changedCells.size() + nBits > nMaxChanges) { // Too many changes, redraw everything
+			bFullUpdate = true;
+			changedCells.clear();
+		}
+		if (!bFullUpdate) {
+			for (uint64_t remaining = bits; remaining != 0; remaining &= remaining - 1) {
+				markChanged(y * nSizeX + 64 * w + BitPlane::lowestBit(remaining));
+			}
+		}
+		coveredRow[w] &= ~mask;
+		flaggedRow[w] &= ~mask;
+		unknownRow[w] &= ~mask;
+	}
+	return nUncovered;
+}
+
+void Minefield::markChanged(const int& cell) {
+	if (bFullUpdate)
+		return;
+	if ((int)changedCells.size() >= nMaxChanges) { // Too many changes, redraw everything
+		bFullUpdate = true;
+		changedCells.clear();
+		return;
+	}
+	changedCells.push_back(cell);
+}
+
+template <class Topology>
+void Minefield::getNeighbors(std::vector<int>& vec, const int& x, const int& y) const {
+	int neighbors[Topology::nMaxNeighbors];
+	const int nNeighbors = Topology::getNeighbors(grid, x, y, neighbors);
+	vec.clear();
+	vec.push_back(y * nSizeX + x);
+	vec.insert(vec.end(), neighbors, neighbors + nNeighbors);
+}
+
+void Minefield::getNeighbors(std::vector<int>& vec, const int& x, const int& y) const {
+	switch (topology) {
+	case Topologies::TORUS:
+		getNeighbors<TorusTopology>(vec, x, y);
+		break;
+	case Topologies::HEX:
+		getNeighbors<HexTopology>(vec, x, y);
+		break;
+	case Topologies::CUBIC:
+		getNeighbors<CubicTopology>(vec, x, y);
+		break;
+	default:
+		getNeighbors<SquareTopology>(vec, x, y);
+		break;
+	}
+}
+
+bool Minefield::getNeighbors(std::vector<int>& vec, const TileTypes& type, const int& x, const int& y) const {
+	getNeighbors(vec, x, y);
+	vec.erase(std::remove_if(vec.begin(), vec.end(), [this, &type](const int& cell) { return (getTileType(cell) != type); }), vec.end());
+	return !vec.empty();
+}
+
+void Minefield::uncoverCell(const int& x, const int& y) {
+	uncoverCell(y * nSizeX + x);
+}
+
+void Minefield::uncoverCell(const int& cell) {
+	if (bFirstCell)
+		placeBombs(cell);
+	beginMove();
+	switch (getTileType(cell)) {
+	case TileTypes::ZERO: // Blank space (no surrounding mines)
+		fillArea(cell);
+		break;
+	case TileTypes::BOMB: // KABOOM
+		setTileType(cell, TileTypes::EXPLOSION);
+		endGame(false);
+		break;
+	default:
+		decrement();
+		break;
+	}
+	uncover(cell % nSizeX, cell / nSizeX);
+	endMove();
+}
+
+bool Minefield::chordCell(const int& x, const int& y) {
+	const int cell = y * nSizeX + x;
+	if (covered.get(x, y) || minefield[cell] == 0 || minefield[cell] > 8) // Not an uncovered and numbered cell
+		return false;
+	// Left clicking an uncovered and numbered cell will uncover all surrounding
+	// cells if a matching number of flags exist around the cell.
+	getNeighbors(chordNeighbors, x, y);
+	unsigned char nFlags = 0;
+	for (auto neighbor = chordNeighbors.begin(); neighbor != chordNeighbors.end(); neighbor++) {
+		if (getCover(*neighbor) == 2) // Flagged cell
+			nFlags++;
+	}
+	if (nFlags != minefield[cell])
+		return false;
+	beginMove(); // Undone as a single move
+	for (auto neighbor = chordNeighbors.begin(); neighbor != chordNeighbors.end(); neighbor++) { // Uncover all neighboring cells
+		if (getCover(*neighbor) != 1)
+			continue;
+		uncoverCell(*neighbor);
+	}
+	endMove();
+	return true;
+}
+
+void Minefield::cycleFlag(const int& cell) {
+	const int x = cell % nSizeX;
+	const int y = cell / nSizeX;
+	const unsigned char cover = getCover(x, y);
+	if (cover == 0) // Uncovered
+		return;
+	beginMove();
+	saveWord(y, x >> 6);
+	switch (cover) {
+	case 1: // Flag cell
+		flagged.set(x, y);
+		break;
+	case 2: // Mark cell as unknown (?)
+		flagged.reset(x, y);
+		unknown.set(x, y);
+		break;
+	default: // Un-flag cell
+		unknown.reset(x, y);
+		break;
+	}
+	markChanged(cell);
+	endMove();
+}
+
+void Minefield::decrement() {
+	if (--nRemainingCells == 0) {
+		endGame(true);
+	}
+}
+
+void Minefield::setHistoryEnabled(const bool& enabled) {
+	bHistory = enabled;
+	clearHistory();
+	if (bHistory)
+		allocateHistory();
+	else
+		touchedWords = std::vector<unsigned char>();
+}
+
+size_t Minefield::getHistorySize() const {
+	return moveHistory.size() * sizeof(MoveDelta) + historyWords.size() * sizeof(uint32_t) +
+		historyMasks.size() * sizeof(uint64_t) + historyTiles.size() * sizeof(TileDelta);
+}
+
+bool Minefield::undo() {
+	if (nMoveDepth > 0 || nHistoryPosition == 0)
+		return false;
+	applyMove(--nHistoryPosition, true);
+	return true;
+}
+
+bool Minefield::redo() {
+	if (nMoveDepth > 0 || nHistoryPosition >= moveHistory.size())
+		return false;
+	applyMove(nHistoryPosition++, false);
+	return true;
+}
+
+void Minefield::allocateHistory() {
+	// Enough for a game which reveals or flags every cell once and then ends (which saves every word), so that
+	// moves do not allocate while playing. Only part of it is reserved for very large minefields.
+	const size_t nMaxReserved = 1 << 18;
+	const size_t nCells = (size_t)nSizeX * nSizeY;
+	const size_t nMoves = std::min(2 * nCells, nMaxReserved);
+	touchedWords.assign(getPlaneWords(), 0);
+	moveHistory.reserve(nMoves);
+	historyWords.reserve(std::min(nMoves + getPlaneWords(), 2 * nMaxReserved));
+	historyMasks.reserve(3 * historyWords.capacity());
+	historyTiles.reserve(std::min(nCells, nMaxReserved));
+}
+
+void Minefield::clearHistory() {
+	nMoveDepth = 0;
+	nHistoryPosition = 0;
+	moveHistory.clear();
+	historyWords.clear();
+	historyMasks.clear();
+	historyTiles.clear();
+}
+
+void Minefield::beginMove() {
+	if (!bHistory || nMoveDepth++ > 0)
+		return;
+	if (nHistoryPosition < moveHistory.size()) { // A new move replaces the undone moves
+		historyWords.resize(moveHistory[nHistoryPosition].nFirstWord);
+		historyMasks.resize(3 * moveHistory[nHistoryPosition].nFirstWord);
+		historyTiles.resize(moveHistory[nHistoryPosition].nFirstTile);
+		moveHistory.resize(nHistoryPosition);
+	}
+	const MoveDelta move = { historyWords.size(), historyTiles.size(), nRemainingCells, nRemainingCells, gameState, gameState };
+	moveHistory.push_back(move);
+}
+
+void Minefield::endMove() {
+	if (nMoveDepth == 0 || --nMoveDepth > 0)
+		return;
+	MoveDelta& move = moveHistory.back();
+	move.nRemainingAfter = nRemainingCells;
+	move.stateAfter = gameState;
+
+	// Replace the saved words with their changes, dropping words which did not change
+	const int nRowWords = covered.getRowWords();
+	size_t nWords = move.nFirstWord;
+	for (size_t i = move.nFirstWord; i < historyWords.size(); i++) {
+		const uint32_t word = historyWords[i];
+		touchedWords[word] = 0;
+		const int y = (int)(word / nRowWords);
+		const int w = (int)(word % nRowWords);
+		const uint64_t coveredMask = historyMasks[3 * i] ^ covered.getRow(y)[w];
+		const uint64_t flaggedMask = historyMasks[3 * i + 1] ^ flagged.getRow(y)[w];
+		const uint64_t unknownMask = historyMasks[3 * i + 2] ^ unknown.getRow(y)[w];
+		if ((coveredMask | flaggedMask | unknownMask) == 0)
+			continue;
+		historyWords[nWords] = word;
+		historyMasks[3 * nWords] = coveredMask;
+		historyMasks[3 * nWords + 1] = flaggedMask;
+		historyMasks[3 * nWords + 2] = unknownMask;
+		nWords++;
+	}
+	historyWords.resize(nWords);
+	historyMasks.resize(3 * nWords);
+
+	// Moves which changed nothing (such as flagging an uncovered cell) can not be undone
+	if (nWords == move.nFirstWord && historyTiles.size() == move.nFirstTile && move.nRemainingBefore == move.nRemainingAfter && move.stateBefore == move.stateAfter)
+		moveHistory.pop_back();
+	nHistoryPosition = moveHistory.size();
+}
+
+void Minefield::saveWord(const int& y, const int& w) {
+	if (nMoveDepth == 0)
+		return;
+	const uint32_t word = (uint32_t)(y * covered.getRowWords() + w);
+	if (touchedWords[word])
+		return;
+	touchedWords[word] = 1;
+	historyWords.push_back(word);
+	historyMasks.push_back(covered.getRow(y)[w]);
+	historyMasks.push_back(flagged.getRow(y)[w]);
+	historyMasks.push_back(unknown.getRow(y)[w]);
+}
+
+void Minefield::saveTile(const int& cell, const unsigned char& value) {
+	if (nMoveDepth == 0)
+		return;
+	const TileDelta tile = { cell, (unsigned char)(minefield[cell] ^ value) };
+	historyTiles.push_back(tile);
+}
+
+void Minefield::applyMove(const size_t& index, const bool& bUndo) {
+	const MoveDelta& move = moveHistory[index];
+	const bool bLast = (index + 1 == moveHistory.size());
+	const size_t nLastWord = (bLast ? historyWords.size() : moveHistory[index + 1].nFirstWord);
+	const size_t nLastTile = (bLast ? historyTiles.size() : moveHistory[index + 1].nFirstTile);
+	if (move.stateBefore != move.stateAfter) { // The whole minefield was uncovered (or is covered again)
+		bFullUpdate = true;
+		changedCells.clear();
+	}
+	const int nRowWords = covered.getRowWords();
+	for (size_t i = move.nFirstWord; i < nLastWord; i++) {
+		const int y = (int)(historyWords[i] / nRowWords);
+		const int w = (int)(historyWords[i] % nRowWords);
+		covered.getRow(y)[w] ^= historyMasks[3 * i];
+		flagged.getRow(y)[w] ^= historyMasks[3 * i + 1];
+		unknown.getRow(y)[w] ^= historyMasks[3 * i + 2];
+		if (bFullUpdate)
+			continue;
+		for (uint64_t bits = historyMasks[3 * i] | historyMasks[3 * i + 1] | historyMasks[3 * i + 2]; bits != 0; bits &= bits - 1) {
+			markChanged(y * nSizeX + 64 * w + BitPlane::lowestBit(bits));
+		}
+	}
+	for (size_t i = move.nFirstTile; i < nLastTile; i++) {
+		minefield[historyTiles[i].nCell] ^= historyTiles[i].nValue;
+		markChanged(historyTiles[i].nCell);
+	}
+	nRemainingCells = (bUndo ? move.nRemainingBefore : move.nRemainingAfter);
+	gameState = (bUndo ? move.stateBefore : move.stateAfter);
+}
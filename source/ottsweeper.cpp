@@ -1,20 +1,41 @@
 #include <iostream>
 #include <algorithm>
 #include <fstream>
-#include <sstream>
-#include <queue>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <memory>
 
 #include "ottsweeper.hpp"
 #include "OTTTexture.hpp"
-#include "OTTSpriteSet.hpp"
 #include "OTTSystem.hpp"
 #include "OTTConfigFile.hpp"
 
+#include <GLFW/glfw3.h>
+
+#include "alloccount.hpp"
+#include "atlas.hpp"
+
 Ottsweeper* winptr = 0x0;
 
+// Time the program started (approximately), for measuring the time to the first frame
+const std::chrono::steady_clock::time_point launchTime = std::chrono::steady_clock::now();
+
+// Steady clock time (in nanoseconds)
+uint64_t getTimestamp() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Convert window pixels to unscaled minefield pixels at a camera zoom level
+int unscaleView(const int& pixels, const int& zoom) {
+	return (zoom >= 0 ? pixels >> zoom : pixels << -zoom);
+}
+
 void resizeCallback(GLFWwindow* window, int width, int height) {
 	winptr->updateWindowSize(width, height);
 	winptr->setCurrentWindowScale((double)width / winptr->getNativeWidth(), (double)height / winptr->getNativeHeight());
+	winptr->requestRedraw();
 }
 
 bool Ottsweeper::onUserCreateWindow() {
@@ -27,26 +48,15 @@ bool Ottsweeper::onUserCreateWindow() {
 	// Set window resize callback function
 	setWindowResizeCallback(resizeCallback);
 
-	// Setup tile map
-	gridMap[TileTypes::ZERO] = 0;
-	gridMap[TileTypes::ONE] = 1;
-	gridMap[TileTypes::TWO] = 2;
-	gridMap[TileTypes::THREE] = 3;
-	gridMap[TileTypes::FOUR] = 4;
-	gridMap[TileTypes::FIVE] = 5;
-	gridMap[TileTypes::SIX] = 6;
-	gridMap[TileTypes::SEVEN] = 7;
-	gridMap[TileTypes::EIGHT] = 8;
-	gridMap[TileTypes::BOMB] = 9;
-	gridMap[TileTypes::EXPLOSION] = 10;
-	gridMap[TileTypes::MISTAKE] = 11;
-	gridMap[TileTypes::NORMAL] = 12;
-	gridMap[TileTypes::FLAGGED] = 13;
-	gridMap[TileTypes::UNKNOWN] = 14;
-
 	// Read input config file
 	std::string configFilePath = "default.cfg";
-	std::string assetsFilePath = "tiles.png";
+	std::string assetsFilePath; // Use the atlas compiled into the game unless set
+	int nSizeX = 10;
+	int nSizeY = 10;
+	int nBombs = 10;
+	int nMaxViewX = 60;
+	int nMaxViewY = 32;
+	bool bSeeded = false;
 	ConfigFile cfgFile;
 	if (cfgFile.read(configFilePath)) { // Read configuration file
 		if (cfgFile.search("MINES", true))
@@ -56,21 +66,45 @@ bool Ottsweeper::onUserCreateWindow() {
 		if (cfgFile.search("ROWS", true))
 			nSizeY = (int)cfgFile.getUInt();
 		if (cfgFile.search("DIFFICULTY", true)) {
-			const int diffX[9] = { 10, 9, 8, 16, 16, 15, 15, 15, 30 };
-			const int diffY[9] = { 10, 9, 8, 16, 15, 15, 14, 13, 16 };
-			const int diffB[9] = { 10, 10, 10, 40, 40, 40, 40, 40, 99 };
 			const unsigned int difficulty = cfgFile.getUInt();
-			if (difficulty < 9) {
-				nSizeX = diffX[difficulty];
-				nSizeY = diffY[difficulty];
-				nBombs = diffB[difficulty];
+			if (Minefield::getDifficulty(difficulty, nSizeX, nSizeY, nBombs)) {
 				std::cout << " Set difficulty level to " << difficulty << "." << std::endl;
 			}
 			else {
 				std::cout << " Error! Invalid difficulty specified (" << difficulty << ")." << std::endl;
 			}
 		}
-		if (cfgFile.search("TEXTURES", true))
+		if (cfgFile.search("TOPOLOGY", true)) {
+			if (!getTopology(cfgFile.getCurrentParameterString(), topology))
+				std::cout << " Error! Invalid topology specified (" << cfgFile.getCurrentParameterString() << ")." << std::endl;
+		}
+		if (cfgFile.search("LAYERS", true))
+			nLayerRows = std::max(1, (int)cfgFile.getUInt()); // Converted to rows per layer below
+		if (cfgFile.search("NOGUESS", true))
+			bNoGuess = (cfgFile.getUInt() != 0);
+		if (cfgFile.search("ENDLESS", true))
+			bEndless = (cfgFile.getUInt() != 0);
+		if (cfgFile.search("RECORD", true))
+			recordFile = cfgFile.getCurrentParameterString();
+		if (cfgFile.search("REPLAY", true))
+			bReplaying = player.open(cfgFile.getCurrentParameterString());
+		if (cfgFile.search("SEED", true)) {
+			nSeed = std::strtoull(cfgFile.getCurrentParameterString().c_str(), 0x0, 10);
+			bSeeded = true;
+		}
+		if (cfgFile.search("SNAPSHOT", true))
+			snapshotFile = cfgFile.getCurrentParameterString();
+		if (cfgFile.search("FRAMETIMES", true))
+			timingFile = cfgFile.getCurrentParameterString();
+		if (cfgFile.search("ONDEMAND", true))
+			bOnDemand = (cfgFile.getUInt() != 0);
+		if (cfgFile.search("INPUTTHREAD", true))
+			bInputThread = (cfgFile.getUInt() != 0);
+		if (cfgFile.search("VIEWCOLS", true))
+			nMaxViewX = std::max(1, (int)cfgFile.getUInt());
+		if (cfgFile.search("VIEWROWS", true))
+			nMaxViewY = std::max(1, (int)cfgFile.getUInt());
+		if (cfgFile.search("TEXTURES", true) && cfgFile.getCurrentParameterString() != "tiles.png") // Older config files set the default atlas, which is built in
 			assetsFilePath = cfgFile.getCurrentParameterString();
 	}
 	else {
@@ -92,45 +126,229 @@ bool Ottsweeper::onUserCreateWindow() {
 		ofile << "MINES      10" << std::endl;
 		ofile << "COLS       10" << std::endl;
 		ofile << "ROWS       10" << std::endl;
-		ofile << "TEXTURES   tiles.png" << std::endl;
+		ofile << "# Board shape (square, torus, hex, or cubic). Cubic minefields have LAYERS layers of ROWS rows." << std::endl;
+		ofile << "#TOPOLOGY   hex" << std::endl;
+		ofile << "#LAYERS     4" << std::endl;
+		ofile << "# Only generate boards which can be solved without guessing" << std::endl;
+		ofile << "#NOGUESS    1" << std::endl;
+		ofile << "# Seed of the mine layouts (the same seed always gives the same sequence of boards)" << std::endl;
+		ofile << "#SEED       12345" << std::endl;
+		ofile << "# Endless mode (window size and mine density set by COLS, ROWS, and MINES)" << std::endl;
+		ofile << "#ENDLESS    1" << std::endl;
+		ofile << "# Record the last game, or play back a recorded game" << std::endl;
+		ofile << "#RECORD     last.otr" << std::endl;
+		ofile << "#REPLAY     last.otr" << std::endl;
+		ofile << "# Save an unfinished game at exit, and resume it the next time the game starts" << std::endl;
+		ofile << "#SNAPSHOT   saved.ots" << std::endl;
+		ofile << "# Write recent frame times at exit (Chrome trace if the name ends with .json, CSV otherwise)" << std::endl;
+		ofile << "#FRAMETIMES frametimes.csv" << std::endl;
+		ofile << "# Only draw when the board or timer changes, and sleep until the next input in between" << std::endl;
+		ofile << "#ONDEMAND   1" << std::endl;
+		ofile << "# Run the game logic on its own thread, so that slow moves do not delay drawing or input" << std::endl;
+		ofile << "#INPUTTHREAD 1" << std::endl;
+		ofile << "# Largest part of the minefield shown in the window (larger minefields can be scrolled and zoomed)" << std::endl;
+		ofile << "#VIEWCOLS   60" << std::endl;
+		ofile << "#VIEWROWS   32" << std::endl;
+		ofile << "# Load the sprite atlas from an image instead of using the one built into the game" << std::endl;
+		ofile << "# (tiles.png is the built-in atlas, and is only loaded if the game was built without one)" << std::endl;
+		ofile << "#TEXTURES   my_tiles.png" << std::endl;
 		ofile << std::endl; // Add an extra new line to make sure we keep the final variable
 		ofile.close();
 	}
 
-	// Numerical digits (13x23, 10 sprites)
-	OTTTexture sweeperAssets(assetsFilePath);
-	sweeperAssets.increaseColorDepth(4);
-	digits.addSprites(&sweeperAssets, 0, 0, 13, 23, 10, 1);
+	// Load sprite atlas (an RGBA copy is compiled into the game, unless it was built without one)
+	const std::chrono::steady_clock::time_point atlasStart = std::chrono::steady_clock::now();
+	const unsigned char* atlasPixels = 0x0;
+	int nAtlasWidth = 0;
+	int nAtlasHeight = 0;
+	std::unique_ptr<OTTTexture> sweeperAssets;
+	if (!assetsFilePath.empty() || !getEmbeddedAtlas(atlasPixels, nAtlasWidth, nAtlasHeight)) {
+		sweeperAssets.reset(new OTTTexture(assetsFilePath.empty() ? std::string("tiles.png") : assetsFilePath));
+		sweeperAssets->increaseColorDepth(4);
+		atlasPixels = sweeperAssets->get();
+		nAtlasWidth = sweeperAssets->getWidth();
+		nAtlasHeight = sweeperAssets->getHeight();
+	}
+
+	// Upload sprite atlas for batched minefield, counter, and smiley rendering
+	if (!batch.initialize(atlasPixels, nAtlasWidth, nAtlasHeight))
+		return false;
+	dAtlasLoadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - atlasStart).count();
+
+	// Compile window frame shader
+	if (!background.initialize())
+		return false;
 
 	// Field tiles (16x16, 9+6 sprites)
-	tiles.addSprites(&sweeperAssets, 0, 23, 16, 16, 9, 2);
+	batch.addSprites(0, 23, 16, 16, 9, 2);
+
+	// Numerical digits (13x23, 10 sprites)
+	nFirstDigitSprite = batch.addSprites(0, 0, 13, 23, 10, 1);
 
 	// Smiley faces (24x24, 3 sprites)
-	smilies.addSprites(&sweeperAssets, 0, 55, 24, 24, 3, 1);
+	nFirstFaceSprite = batch.addSprites(0, 55, 24, 24, 3, 1);
+
+	// Other topologies are only supported for ordinary games
+	if (topology != Topologies::SQUARE && (bEndless || bReplaying)) {
+		std::cout << " Warning! Endless minefields and replays only support the square topology." << std::endl;
+		topology = Topologies::SQUARE;
+	}
+
+	// Cubic minefields stack their layers in the rows of the minefield
+	if (topology == Topologies::CUBIC) {
+		const int nLayers = std::max(1, nLayerRows);
+		nLayerRows = nSizeY;
+		nSizeY *= nLayers;
+	}
+
+	// Replays set their own minefield size
+	if (bReplaying && bEndless) {
+		std::cout << " Warning! Replays are not supported for endless minefields." << std::endl;
+		bReplaying = false;
+	}
+	else if (bReplaying) {
+		nSizeX = player.getWidth();
+		nSizeY = player.getHeight();
+		nBombs = player.getMines();
+		bNoGuess = false;
+		recordFile.clear();
+		std::cout << " Replaying " << player.getEventCount() << " moves." << std::endl;
+		std::cout << "  Use , and . to skip back and forward 10 moves." << std::endl;
+	}
+
+	// Resumed games set their own minefield size
+	Snapshot snapshot;
+	if (!snapshotFile.empty() && (bEndless || bReplaying)) {
+		std::cout << " Warning! Snapshots are not supported for endless minefields or replays." << std::endl;
+		snapshotFile.clear();
+	}
+	else if (!snapshotFile.empty() && std::ifstream(snapshotFile.c_str()).good() && snapshot.open(snapshotFile)) { // No saved game is not an error
+		nSizeX = snapshot.getWidth();
+		nSizeY = snapshot.getHeight();
+		nBombs = snapshot.getMines();
+		topology = snapshot.getTopology();
+		nLayerRows = snapshot.getLayerRows();
+		std::cout << " Resuming saved game from " << snapshotFile << "." << std::endl;
+	}
+
+	// Boards which can be solved without guessing, and recordings, are only made for square minefields
+	if (topology != Topologies::SQUARE && bNoGuess) {
+		std::cout << " Warning! Boards which can be solved without guessing are only generated for the square topology." << std::endl;
+		bNoGuess = false;
+	}
+	if (topology != Topologies::SQUARE && !recordFile.empty()) {
+		std::cout << " Warning! Recording is only supported for the square topology." << std::endl;
+		recordFile.clear();
+	}
+
+	// Seed random number generators (each one uses its own stream of the seed)
+	if (bSeeded)
+		std::cout << " Random seed set to " << nSeed << "." << std::endl;
+	else
+		nSeed = SplitMix::randomSeed();
+	field.setSeed(SplitMix::split(nSeed, 0));
+	generator.setSeed(SplitMix::split(nSeed, 1));
+
+	// Setup minefield
+	field.setSize(nSizeX, nSizeY, nBombs);
+	if (topology != Topologies::SQUARE && !field.setTopology(topology, nLayerRows))
+		topology = Topologies::SQUARE; // Shape not supported by this minefield size
+	field.setHistoryEnabled(!bEndless && !bReplaying);
 
 	// Print minefield info
-	std::cout << " Minefield size set to (" << nSizeX << " x " << nSizeY << ", " << nBombs << " mines)." << std::endl;
+	if (bEndless) {
+		endless.setDensity((double)nBombs / (nSizeX * nSizeY));
+		std::cout << " Endless minefield view set to (" << nSizeX << " x " << nSizeY << ", " << 100 * endless.getDensity() << "% mines)." << std::endl;
+		std::cout << "  Use W, A, S, and D to scroll." << std::endl;
+	}
+	else {
+		std::cout << " Minefield size set to (" << nSizeX << " x " << nSizeY << ", " << nBombs << " mines)." << std::endl;
+		if (topology == Topologies::CUBIC)
+			std::cout << "  Cubic minefield of " << nSizeY / nLayerRows << " layers, shown from top to bottom." << std::endl;
+		else if (topology != Topologies::SQUARE)
+			std::cout << "  Using " << getTopologyName(topology) << " topology." << std::endl;
+	}
+	nRowShift = (hasOffsetRows(field.getTopology()) ? 8 : 0); // After any fallback to the square topology
+
+	// Only part of a large minefield fits in the window (the endless minefield view is always the size of the window)
+	nViewColumns = (bEndless ? nSizeX : std::min(nSizeX, nMaxViewX));
+	nViewRows = (bEndless ? nSizeY : std::min(nSizeY, nMaxViewY));
+	if (nViewColumns < nSizeX || nViewRows < nSizeY) {
+		std::cout << " Showing " << nViewColumns << " x " << nViewRows << " cells." << std::endl;
+		std::cout << "  Use W, A, S, and D to scroll, and - and = to zoom." << std::endl;
+	}
 
 	// Change the size of the window
 	// Vertical borders: 3 pixels of White, 6 pixels of Gray, 3 pixels of Dark Gray
 	// Horizontal borders: 3 pixels of White, 5 pixels of Gray, 3 pixels of Dark Gray
-	nNativeWidth = 2 * (3 + 6 + 3) + nSizeX * 16;
-	nNativeHeight = 3 * (3 + 5 + 3) + nSizeY * 16 + 32; // Plus 32 pixel header
+	nNativeWidth = 2 * (3 + 6 + 3) + nViewColumns * 16 + nRowShift;
+	nNativeHeight = 3 * (3 + 5 + 3) + nViewRows * 16 + 32; // Plus 32 pixel header
 	updateWindowSize(nNativeWidth, nNativeHeight, true);
 
-	// Generate background texture
-	generateBackground();
+	// Lay out the window frame (drawn by a shader, so its cost does not depend on the minefield size)
+	layoutBackground();
 
-	// Seed random number generator
-	rng.seed();
+	// Setup batched tile rendering
+	batch.setScreenSize(nNativeWidth, nNativeHeight);
+	batch.setCounterPosition(0, 16, 15); // Remaining mines
+	batch.setCounterPosition(1, nNativeWidth - 55, 15); // Time
+	batch.setFacePosition(nNativeWidth / 2 - 12, 15);
 
-	// Setup minefield
-	minefield = std::vector<unsigned char>(nSizeY * nSizeX, 0);
-	playfield = std::vector<unsigned char>(nSizeY * nSizeX, 1);
+	// Setup the camera (only the cells in view are drawn)
+	if (bEndless) {
+		batch.setGrid(nMinefieldOffsetX, nMinefieldOffsetY, nSizeX, nSizeY, 16);
+	}
+	else {
+		nMinZoom = 0;
+		while (nMinZoom > -2 && (nViewColumns << (1 - nMinZoom)) <= nSizeX && (nViewRows << (1 - nMinZoom)) <= nSizeY) {
+			nMinZoom--; // Zooming out does not show past the edge of the minefield
+		}
+		int nMaxCols = 0;
+		int nMaxRows = 0;
+		getGridSize(nMinZoom, nMaxCols, nMaxRows);
+		batch.reserve(nMaxCols * nMaxRows);
+		shownTiles.assign(field.getCells(), 0);
+		moveCamera(0, 0, 0);
+	}
+
+	// Start generating boards which can be solved without guessing
+	if (bNoGuess && !bEndless) {
+		std::cout << " Generating boards which can be solved without guessing." << std::endl;
+		generator.prepare(nSizeX, nSizeY, nBombs);
+	}
+
+	// Allocate scratch buffers used by the frame loop
+	previewCells.reserve(9);
+	drawnPreviewCells.reserve(9);
+	boardLayout.reserve(nBombs);
+	windowTitle.reserve(64);
 
 	// Randomize bomb placement
+	dTotalTime = 0;
 	resetField();
 
+	// Restore the saved game
+	if (snapshot.isOpen()) {
+		const auto loadStart = std::chrono::steady_clock::now();
+		if (snapshot.restore(field)) {
+			dTotalTime = snapshot.getTime();
+			bUnrecordedGame = !field.isFirstCell();
+			std::cout << "  Restored in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count() << " ms." << std::endl;
+		}
+		snapshot.close();
+	}
+
+	// Start the game logic thread (the window and input must stay on the main thread)
+	if (bInputThread && (bEndless || bReplaying)) {
+		std::cout << " Warning! The game logic thread is not supported for endless minefields or replays." << std::endl;
+		bInputThread = false;
+	}
+	else if (bInputThread) {
+		tileQueue.resize(65536); // Fixed size, setTile() waits for the frame loop to empty it during large cascades
+		logicThread = std::thread(&Ottsweeper::logicLoop, this);
+		std::cout << " Running game logic on its own thread." << std::endl;
+	}
+
 	// Success
 	return true;
 }
@@ -140,459 +358,667 @@ bool Ottsweeper::onUserLoop() {
 
 	//clear(); // Clear the screen
 
+	frameTimer.beginFrame();
+	frameTimer.enterPhase(FramePhases::INPUT);
+	const unsigned long long nStartAllocations = AllocationCounter::getAllocations();
+
+	// Game time of moves made this frame (set by each input event when the game logic runs on its own thread)
+	if (!bInputThread)
+		dGameTime = dTotalTime;
+
 	// Check for key presses
 	if (keys.poll('r')) { // Reset
-		resetField();
+		sendInput(InputEvents::RESET, -1);
 	}
-
-	// Check for mouse events
-	std::vector<int> neighbors;
-	nCurrentCellX = ((int)(mouse.getX() / dWindowScaleX) - nMinefieldOffsetX) / 16;
-	nCurrentCellY = ((int)(mouse.getY() / dWindowScaleY) - nMinefieldOffsetY) / 16;
-	nCurrentCell = nCurrentCellY * nSizeX + nCurrentCellX;
-	bLeftClickHeld = false;
-	if (nCurrentCellX >= 0 && nCurrentCellY >= 0) {
-		if (mouse.check(0)) { // LMB pressed
-			bLeftClickHeld = true;
-		}
-		else if (mouse.released(0)) { // LMB released
-			if (playfield[nCurrentCell] == 0) { // Uncovered cell
-				if (minefield[nCurrentCell] > 0 && mouse.check(1)) { // Mouse is hovering over a numbered cell and right mouse button is being held 
-					// If the mouse is currently over an uncovered and numbered cell, left clicking will uncover
-					// all surrounding cells if a matching number of flags exist around the cell.
-					std::vector<int> tempNeighbors;
-					getNeighbors(tempNeighbors, nCurrentCellX, nCurrentCellY);
-					unsigned char nFlags = 0;
-					for (auto neighbor = tempNeighbors.begin(); neighbor != tempNeighbors.end(); neighbor++) {
-						if (playfield[*neighbor] == 2) // Flagged cell
-							nFlags++;
-					}
-					if (nFlags == minefield[nCurrentCell]) { // Uncover all neighboring cells
-						for (auto neighbor = tempNeighbors.begin(); neighbor != tempNeighbors.end(); neighbor++) {
-							if (playfield[*neighbor] != 1)
-								continue;
-							uncoverCell(*neighbor);
-						}
-					}
-				}
-			}
-			else if (playfield[nCurrentCell] != 2) { // Cell currently hidden (but not flagged)
-				uncoverCell(nCurrentCell);
-			}
+	if (keys.poll('h')) { // Hint
+		sendInput(InputEvents::HINT, -1);
+	}
+	if (keys.poll('p')) { // Mine probabilities
+		sendInput(InputEvents::PROBABILITIES, -1);
+	}
+	if (keys.poll('z')) { // Undo
+		sendInput(InputEvents::UNDO, -1);
+	}
+	if (keys.poll('y')) { // Redo
+		sendInput(InputEvents::REDO, -1);
+	}
+	if (keys.poll('t')) { // Frame times
+		frameTimer.print();
+		frameTimer.write(timingFile.empty() ? "frametimes.csv" : timingFile);
+	}
+	if (bReplaying) { // Skip through the replay
+		const size_t position = player.getPosition();
+		bool bSeek = false;
+		ScopedPhaseTimer timer(frameTimer, FramePhases::LOGIC);
+		if (keys.poll(',')) {
+			player.seek(field, (position > 10 ? position - 10 : 0));
+			bSeek = true;
 		}
-		if (mouse.check(1)) { // RMB held
-			if (playfield[nCurrentCell] == 0) { // Cell is uncovered
-				// If the mouse is currently over an uncovered cell, all surrounding uncovered cells will appear
-				// uncovered and blank (but will remain covered).
-				getNeighbors(neighbors, nCurrentCellX, nCurrentCellY);
-			}
+		if (keys.poll('.')) {
+			player.seek(field, position + 10);
+			bSeek = true;
 		}
-		else if (mouse.released(1)) { // RMB released
-			switch (playfield[nCurrentCell]) {
-			case 1: // Flag cell
-				playfield[nCurrentCell] = 2;
-				break;
-			case 2: // Mark cell as unknown (?)
-				playfield[nCurrentCell] = 3;
-				break;
-			case 3: // Un-flag cell
-				playfield[nCurrentCell] = 1;
-				break;
-			default:
-				break;
-			}
+		if (bSeek) {
+			dTotalTime = player.getTime();
+			gameState = GameStates::NORMAL;
 		}
 	}
-	else if (mouse.poll(0)) { // Check for LMB clicked on smiley face
-		const int smileX[2] = { nNativeWidth / 2.f - 12, nNativeWidth / 2.f + 12 };
-		const int smileY[2] = { 15, 39 };
-		const int mx = (int)mouse.getX();
-		const int my = (int)mouse.getY();
-		if (mx >= smileX[0] && mx <= smileX[1] && my >= smileY[0] && my <= smileY[1]) {
-			resetField();
+	if (bEndless) { // Scroll the endless minefield by a quarter of the window
+		if (keys.poll('w'))
+			nViewY -= std::max(1, field.getHeight() / 4);
+		if (keys.poll('s'))
+			nViewY += std::max(1, field.getHeight() / 4);
+		if (keys.poll('a'))
+			nViewX -= std::max(1, field.getWidth() / 4);
+		if (keys.poll('d'))
+			nViewX += std::max(1, field.getWidth() / 4);
+	}
+	else { // Scroll the camera by a quarter of the window, or zoom in and out
+		const int nStepX = std::max(16, unscaleView(nViewColumns * 16 / 4, nZoom));
+		const int nStepY = std::max(16, unscaleView(nViewRows * 16 / 4, nZoom));
+		if (keys.poll('w'))
+			moveCamera(0, -nStepY, 0);
+		if (keys.poll('s'))
+			moveCamera(0, nStepY, 0);
+		if (keys.poll('a'))
+			moveCamera(-nStepX, 0, 0);
+		if (keys.poll('d'))
+			moveCamera(nStepX, 0, 0);
+		if (keys.poll('-'))
+			moveCamera(0, 0, -1);
+		if (keys.poll('='))
+			moveCamera(0, 0, 1);
+	}
+
+	// Check for mouse events (window pixels are mapped to minefield pixels through the camera)
+	const int nMouseX = (int)(mouse.getX() / dWindowScaleX) - nMinefieldOffsetX;
+	const int nMouseY = (int)(mouse.getY() / dWindowScaleY) - nMinefieldOffsetY;
+	const bool bInView = (nMouseX >= 0 && nMouseY >= 0 && nMouseX < nViewColumns * 16 + nRowShift && nMouseY < nViewRows * 16);
+	nCurrentCellY = (bInView ? (nCameraY + unscaleView(nMouseY, nZoom)) / 16 : -1);
+	const int nCellPixelX = nCameraX + unscaleView(nMouseX, nZoom) - (nCurrentCellY & 1) * nRowShift; // Odd rows may be shifted
+	nCurrentCellX = (bInView && nCellPixelX >= 0 ? nCellPixelX / 16 : -1);
+	nCurrentCell = nCurrentCellY * field.getWidth() + nCurrentCellX;
+	bLeftClickHeld = false;
+	const bool bInField = (nCurrentCellX >= 0 && nCurrentCellY >= 0 && nCurrentCellX < field.getWidth() && nCurrentCellY < field.getHeight());
+	if (bReplaying) {
+		ScopedPhaseTimer timer(frameTimer, FramePhases::LOGIC);
+		updateReplay();
+	}
+	else if (bInField && bEndless) {
+		ScopedPhaseTimer timer(frameTimer, FramePhases::LOGIC);
+		previewCells.clear();
+		handleEndlessInput();
+	}
+	else {
+		sampleInput(bInField);
+	}
+
+	frameTimer.enterPhase(FramePhases::LOGIC);
+
+	// Continue revealing a large endless minefield cascade
+	if (bEndless && endless.isCascading()) {
+		endless.continueCascade();
+	}
+
+	// Check for the end of the game
+	if (bEndless && gameState == GameStates::NORMAL && endless.getState() != GameStates::NORMAL) {
+		endGame(endless.getState() == GameStates::WIN);
+	}
+	else if (!bEndless && !bInputThread) {
+		updateGame();
+	}
+
+	// Update tiles which changed since the last frame
+	frameTimer.enterPhase(FramePhases::TILES);
+	uint64_t nShownClick = nPresentedClick;
+	if (bEndless) {
+		updateEndlessTiles();
+	}
+	else if (bInputThread) { // Tiles changed by the game logic thread
+		nShownClick = nAppliedClick.load(std::memory_order_acquire);
+		TileUpdate update;
+		while (tileQueue.pop(update)) {
+			showTile(update.cell, update.tile);
 		}
-		mouse.reset();
 	}
-	
-	// Draw background
-	drawTexture(nBackgroundContext);
+	else {
+		updateTiles();
+		nShownClick = nLastClick;
+	}
 
-	// Draw remaining mines indicator
-	drawNumber(16, 15, nRemainingCells);
+	// Update remaining mines indicator (or revealed cells, for an endless minefield)
+	if (bEndless) {
+		batch.setCounter(0, (int)std::min(endless.getRevealedCells(), 999LL), nFirstDigitSprite);
+	}
+	else {
+		batch.setCounter(0, nRemainingShown.load(std::memory_order_relaxed), nFirstDigitSprite);
+	}
 
-	// Draw the current time
-	if (gameState == GameStates::NORMAL) {
-		drawNumber(nNativeWidth - 55, 15, (int)dTotalTime);
+	// Update the current time
+	const GameStates state = gameState; // May be changed by the game logic thread
+	if (bResumeTimer.exchange(false)) // Continue from the time the game ended
+		dTotalTime = dFinalGameTime;
+	if (state == GameStates::NORMAL) {
+		batch.setCounter(1, (int)dTotalTime, nFirstDigitSprite);
 	}
 	else {
-		drawNumber(nNativeWidth - 55, 15, (int)dFinalGameTime);
+		batch.setCounter(1, (int)dFinalGameTime.load(), nFirstDigitSprite);
 	}
 
-	// Draw the smiley
-	if (gameState == GameStates::NORMAL) {
-		smilies[0].draw(nNativeWidth / 2.f, 27.f);
+	// Update the smiley
+	if (state == GameStates::LOSS) {
+		batch.setFace(nFirstFaceSprite + 1);
 	}
-	else if (gameState == GameStates::LOSS) {
-		smilies[1].draw(nNativeWidth / 2.f, 27.f);
+	else if (state == GameStates::WIN) {
+		batch.setFace(nFirstFaceSprite + 2);
 	}
-	else if (gameState == GameStates::WIN) {
-		smilies[2].draw(nNativeWidth / 2.f, 27.f);
+	else {
+		batch.setFace(nFirstFaceSprite);
 	}
 
-	for (int y = 0; y < nSizeY; y++) { // Over all rows
-		for (int x = 0; x < nSizeX; x++) { // Over all columns
-			int index = y * nSizeX + x;
-			if (playfield[index] == 2) { // Flagged cell
-				drawTile(x, y, TileTypes::FLAGGED);
-			}
-			else if (playfield[index] > 0) { // Tile is hidden
-				if (bLeftClickHeld && index == nCurrentCell) {
-					drawTile(x, y, TileTypes::ZERO);
-					continue;
-				}
-				else if (!neighbors.empty()) { // Right mouse button is being held
-					if (std::find(neighbors.begin(), neighbors.end(), index) != neighbors.end()) {
-						drawTile(x, y, TileTypes::ZERO);
-						continue;
-					}
-				}
-				if (playfield[index] == 1) // Normal cell
-					drawTile(x, y, TileTypes::NORMAL);
-				else if (playfield[index] == 3) // Question mark cell
-					drawTile(x, y, TileTypes::UNKNOWN);
-			}
-			else { // Tile is revealed
-				drawTile(x, y, minefield[index]);
-			}
-		}
+	frameTimer.enterPhase(FramePhases::RENDER);
+
+	// Only the tiles, counters, and smiley change between frames
+	const bool bRedraw = (!bOnDemand || bRedrawRequested || batch.isDirty() || state != drawnState);
+	if (bRedraw) {
+		// Draw background
+		background.draw();
+
+		// Draw the minefield, counters, and smiley
+		batch.draw();
+		bRedrawRequested = false;
+	}
+
+	// Show the result of the game
+	if (state != drawnState && state != GameStates::NORMAL) {
+		char title[64];
+		if (state == GameStates::WIN)
+			std::snprintf(title, sizeof(title), " You Won! Time: %g s", dFinalGameTime.load());
+		else
+			std::snprintf(title, sizeof(title), " You Lose! Try again :)");
+		windowTitle.assign(title);
+		setWindowTitle(windowTitle);
 	}
+	drawnState = state;
 
 	// Print framerate
-	if (gameState == GameStates::NORMAL && (dTotalTime >= dDisplayTime + 2)) {
+	if (state == GameStates::NORMAL && (dTotalTime >= dDisplayTime + 2)) {
 		dDisplayTime = dTotalTime;
-		std::stringstream stream;
-		stream << "Ottsweeper (" << dFramerate << " fps)";
-		setWindowTitle(stream.str());
+		char title[64];
+		std::snprintf(title, sizeof(title), "Ottsweeper (%g fps)", dFramerate);
+		windowTitle.assign(title);
+		setWindowTitle(windowTitle);
 	}
 
+	// Check that the frame did not allocate (only counted in ENABLE_ALLOC_COUNT builds)
+	const unsigned long long nFrameAllocations = AllocationCounter::getAllocations() - nStartAllocations;
+	if (nFrameAllocations > 0 && frameTimer.getFrameCount() > 0)
+		std::cout << " Warning! " << nFrameAllocations << " allocations during frame " << frameTimer.getFrameCount() << "." << std::endl;
+
 	// Draw the screen
-	render();
+	if (bRedraw) {
+		render();
+		if (nShownClick != nPresentedClick) // First frame showing the result of a click
+			frameTimer.setInputLatency(getTimestamp() - nShownClick);
+		if (frameTimer.getFrameCount() == 0) {
+			const double dFirstFrameTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - launchTime).count();
+			std::cout << " First frame drawn " << dFirstFrameTime * 1E3 << " ms after launch (sprite atlas took " << dAtlasLoadTime * 1E3 << " ms)." << std::endl;
+		}
+	}
+	nPresentedClick = nShownClick;
+
+	frameTimer.endFrame();
+
+	// Nothing changed, so sleep until an input event arrives or the timer digits change
+	if (!bRedraw) {
+		const double dTimeout = getIdleTimeout();
+		if (dTimeout < 0)
+			glfwWaitEvents();
+		else if (dTimeout > 0)
+			glfwWaitEventsTimeout(dTimeout);
+	}
 
 	return true;
 }
 
-void Ottsweeper::setTileType(const int& x, const int& y, const TileTypes& type) {
-	minefield[y * nSizeX + x] = gridMap[type];
+double Ottsweeper::getIdleTimeout() const {
+	if (bEndless && endless.isCascading()) // Keep revealing the cascade
+		return 0;
+	if (gameState != GameStates::NORMAL) // Timer is stopped
+		return -1;
+	double dTimeout = -1;
+	if (dTotalTime < 999) // Until just after the timer ticks (the counter stops at 999)
+		dTimeout = std::floor(dTotalTime) + 1 - dTotalTime + 0.001;
+	if (bReplaying && player.getNextEventTime() > dTotalTime) { // Until the next replayed move
+		const double dNextMove = player.getNextEventTime() - dTotalTime;
+		dTimeout = (dTimeout < 0 ? dNextMove : std::min(dTimeout, dNextMove));
+	}
+	return dTimeout;
 }
 
-void Ottsweeper::setTileType(const int& index, const TileTypes& type) {
-	minefield[index] = gridMap[type];
+void Ottsweeper::resetField() {
+	if (bEndless) { // Generate a new endless minefield
+		endless.setSeed(SplitMix::split(SplitMix::split(nSeed, 2), nEndlessBoards++));
+		endless.resetField();
+		nViewX = 0;
+		nViewY = 0;
+	}
+	else if (bReplaying) { // Restart the replay
+		player.reset(field);
+	}
+	else {
+		saveRecording();
+		recorder.clear(); // Flags placed before the first uncovered cell
+		field.resetField();
+	}
+	bUnrecordedGame = false;
+	gameState = GameStates::NORMAL;
 }
 
-TileTypes Ottsweeper::getTileType(const int& x, const int& y) const {
-	return getTileType(y * nSizeX + x);
+void Ottsweeper::endGame(bool bWin) {
+	// The result is shown by the frame loop (the window may only be changed from the main thread)
+	dFinalGameTime = dGameTime;
+	gameState = (bWin ? GameStates::WIN : GameStates::LOSS);
+	saveRecording();
 }
 
-TileTypes Ottsweeper::getTileType(const int& index) const {
-	for (auto type = gridMap.begin(); type != gridMap.end(); type++) {
-		if (type->second == minefield[index])
-			return type->first;
+void Ottsweeper::sendInput(const InputEvents& type, const int& cell) {
+	if (type == InputEvents::RESET) // Reset game timer
+		dTotalTime = 0;
+	InputEvent event;
+	event.type = type;
+	event.cell = cell;
+	event.bLeftHeld = (cell >= 0 && mouse.check(0));
+	event.bRightHeld = (cell >= 0 && mouse.check(1));
+	event.dGameTime = dTotalTime;
+	event.nTimestamp = getTimestamp();
+	if (type == InputEvents::HOVER) {
+		lastHover = event;
+	}
+	if (!bInputThread) {
+		ScopedPhaseTimer timer(frameTimer, FramePhases::LOGIC);
+		applyInput(event);
+		return;
 	}
-	return TileTypes::NONE;
+	while (!inputQueue.push(event)) { // Queue is full, wait for the game logic to catch up
+		std::this_thread::yield();
+	}
+	{ // Make sure the logic thread is either waiting or will see the event before it waits
+		std::lock_guard<std::mutex> guard(logicLock);
+	}
+	logicWake.notify_one();
 }
 
-void Ottsweeper::placeBombs(const int& safeCell) {
-	// Clear minefield
-	std::fill(minefield.begin(), minefield.end(), gridMap[TileTypes::ZERO]);
-
-	int maxBombs = nSizeX * nSizeY;
-	std::vector<int> cellIDs;
-	cellIDs.reserve(maxBombs - 1);
-	for (int i = 0; i < maxBombs; i++) {
-		if(i != safeCell)
-			cellIDs.push_back(i);
-	}
-
-	// Randomly place bombs
-	for (int i = 0; i < nBombs; i++) {
-		int randIndex = rng.rand32() % (maxBombs - i - 1);
-		setTileType(cellIDs.at(randIndex) % nSizeX, cellIDs.at(randIndex) / nSizeX, TileTypes::BOMB);
-		cellIDs.erase(cellIDs.begin() + randIndex);
-	}
-
-	// Count all cell neighbors
-	for (int y = 0; y < nSizeY; y++) { // Over all rows
-		for (int x = 0; x < nSizeX; x++) { // Over all columns
-			if (getTileType(x, y) == TileTypes::BOMB) // Skip bombs
-				continue;
-			unsigned char count = 0;
-			int xlow = std::max(0, x - 1);
-			int xhigh = std::min(nSizeX - 1, x + 1);
-			int ylow = std::max(0, y - 1);
-			int yhigh = std::min(nSizeY - 1, y + 1);
-			for (int yp = ylow; yp <= yhigh; yp++) {
-				for (int xp = xlow; xp <= xhigh; xp++) {
-					if (getTileType(xp, yp) == TileTypes::BOMB)
-						count++;
-				}
-			}
-			minefield[y * nSizeX + x] = count;
+void Ottsweeper::sampleInput(const bool& bInField) {
+	const bool bLeftHeld = (bInField && mouse.check(0));
+	const bool bRightHeld = (bInField && mouse.check(1));
+	if (bInField) {
+		if (!bLeftHeld && mouse.released(0)) // LMB released (chords if RMB is held)
+			sendInput(InputEvents::LEFT_RELEASE, nCurrentCell);
+		if (!bRightHeld && mouse.released(1)) // RMB released
+			sendInput(InputEvents::RIGHT_RELEASE, nCurrentCell);
+	}
+	else if (mouse.poll(0)) { // Check for LMB clicked on smiley face
+		const int smileX[2] = { nNativeWidth / 2.f - 12, nNativeWidth / 2.f + 12 };
+		const int smileY[2] = { 15, 39 };
+		const int mx = (int)mouse.getX();
+		const int my = (int)mouse.getY();
+		if (mx >= smileX[0] && mx <= smileX[1] && my >= smileY[0] && my <= smileY[1]) {
+			sendInput(InputEvents::RESET, -1);
 		}
+		mouse.reset();
 	}
-}
 
-void Ottsweeper::resetField() {
-	std::fill(playfield.begin(), playfield.end(), 1);
-	std::fill(minefield.begin(), minefield.end(), 0);
-	dTotalTime = 0; // Reset game timer
-	nRemainingCells = nSizeX * nSizeY - nBombs;
-	gameState = GameStates::NORMAL;
-	bFirstCell = true;
+	// Cells shown pressed while a button is held
+	const int pressedCell = (bLeftHeld || bRightHeld ? nCurrentCell : -1);
+	if (pressedCell != lastHover.cell || bLeftHeld != lastHover.bLeftHeld || bRightHeld != lastHover.bRightHeld)
+		sendInput(InputEvents::HOVER, pressedCell);
 }
 
-void Ottsweeper::endGame(bool bWin) {
-	if (bWin) { // Win
-		std::stringstream stream;
-		stream << " You Won! Time: " << dTotalTime << " s";
-		setWindowTitle(stream.str());
-		for (int y = 0; y < nSizeY; y++) { // Over all rows
-			for (int x = 0; x < nSizeX; x++) { // Over all columns
-				switch (getTileType(x, y)) {
-				case TileTypes::BOMB: // Bomb
-					setTileType(x, y, TileTypes::FLAGGED);
-					break;
-				default:
-					break;
-				}
-				playfield[y * nSizeX + x] = 0;
+void Ottsweeper::applyInput(const InputEvent& event) {
+	dGameTime = event.dGameTime;
+	switch (event.type) {
+	case InputEvents::HOVER:
+		nHoverCell = event.cell;
+		bHoverLeft = event.bLeftHeld;
+		bHoverRight = event.bRightHeld;
+		break;
+	case InputEvents::LEFT_RELEASE:
+		if (field.getCover(event.cell) == 0) { // Uncovered cell
+			if (event.bRightHeld) { // Right mouse button is being held
+				// If the mouse is currently over an uncovered and numbered cell, left clicking will uncover
+				// all surrounding cells if a matching number of flags exist around the cell.
+				if (field.chordCell(event.cell % field.getWidth(), event.cell / field.getWidth()))
+					recordMove(ReplayEvents::CHORD, event.cell);
 			}
 		}
-		gameState = GameStates::WIN;
-	}
-	else { // Loss
-		std::stringstream stream;
-		stream << " You Lose! Try again :)" << std::endl;
-		setWindowTitle(stream.str());
-		for (int y = 0; y < nSizeY; y++) { // Over all rows
-			for (int x = 0; x < nSizeX; x++) { // Over all columns
-				switch (getTileType(x, y)) {
-				case TileTypes::BOMB:
-					break;
-				default: // Not a bomb
-					if (playfield[y * nSizeX + x] == 2) { // Mis - labeled bomb
-						setTileType(x, y, TileTypes::MISTAKE);
-					}
-					break;
-				}
-				playfield[y * nSizeX + x] = 0;
+		else if (field.getCover(event.cell) != 2) { // Cell currently hidden (but not flagged)
+			if (bNoGuess && field.isFirstCell()) { // Use a board which is solvable from this cell
+				if (generator.getBoard(field.getWidth(), field.getHeight(), field.getBombs(), event.cell, boardLayout))
+					field.setMines(boardLayout);
+				else
+					std::cout << " Warning! Failed to generate a board which can be solved without guessing." << std::endl;
 			}
+			field.uncoverCell(event.cell);
+			recordMove(ReplayEvents::REVEAL, event.cell);
 		}
-		gameState = GameStates::LOSS;
+		nLastClick = event.nTimestamp;
+		break;
+	case InputEvents::RIGHT_RELEASE:
+		if (field.getCover(event.cell) != 0) { // Cell currently hidden
+			field.cycleFlag(event.cell);
+			recordMove(ReplayEvents::FLAG, event.cell);
+		}
+		nLastClick = event.nTimestamp;
+		break;
+	case InputEvents::RESET:
+		resetField();
+		nLastClick = event.nTimestamp;
+		break;
+	case InputEvents::HINT:
+		printScores();
+		break;
+	case InputEvents::PROBABILITIES:
+		computeProbabilities();
+		break;
+	case InputEvents::UNDO:
+	case InputEvents::REDO:
+		if (bEndless || bReplaying)
+			break;
+		if (!(event.type == InputEvents::UNDO ? field.undo() : field.redo()))
+			break;
+		if (!bUnrecordedGame) { // The recording would no longer match the game
+			recorder.clear();
+			bUnrecordedGame = true;
+		}
+		if (field.getState() == GameStates::NORMAL && gameState != GameStates::NORMAL) { // Losing (or winning) move was taken back
+			bResumeTimer = true; // Before the state, so the frame loop never shows the time since the game ended
+			gameState = GameStates::NORMAL;
+		}
+		break;
+	default:
+		break;
 	}
-	dFinalGameTime = dTotalTime;
 }
 
-void Ottsweeper::fillArea(const int& startX, const int& startY) {
-	std::queue<std::pair<int, int> > vec;
-	vec.push(std::make_pair(startX, startY));
-	int x, y;
-	while (!vec.empty()) {
-		x = vec.front().first;
-		y = vec.front().second;
-		vec.pop();
-		if (getTileType(x, y) != TileTypes::ZERO)
-			continue;
-		playfield[y * nSizeX + x] = 0;
-		if (y > 0 && playfield[(y - 1) * nSizeX + x] > 0) { // North
-			if (getTileType(x, y - 1) == TileTypes::ZERO)
-				vec.push(std::make_pair(x, y - 1));
-			playfield[(y - 1) * nSizeX + x] = 0;
-			decrement();
-		}
-		if (x + 1 < nSizeX && playfield[y * nSizeX + x + 1] > 0) { // East
-			if (getTileType(x + 1, y) == TileTypes::ZERO)
-				vec.push(std::make_pair(x + 1, y));
-			playfield[y * nSizeX + x + 1] = 0;
-			decrement();
-		}
-		if (y + 1 < nSizeY && playfield[(y + 1) * nSizeX + x] > 0) { // South
-			if (getTileType(x, y + 1) == TileTypes::ZERO)
-				vec.push(std::make_pair(x, y + 1));
-			playfield[(y + 1) * nSizeX + x] = 0;
-			decrement();
+void Ottsweeper::updateGame() {
+	// Check for the end of the game
+	if (gameState == GameStates::NORMAL && field.getState() != GameStates::NORMAL) {
+		endGame(field.getState() == GameStates::WIN);
+	}
+
+	// Cells shown pressed by the mouse
+	previewCells.clear();
+	nPressedCell = -1;
+	if (nHoverCell >= 0) {
+		if (bHoverLeft)
+			nPressedCell = nHoverCell;
+		if (bHoverRight && field.getCover(nHoverCell) == 0) { // Cell is uncovered
+			// If the mouse is currently over an uncovered cell, all surrounding uncovered cells will appear
+			// uncovered and blank (but will remain covered).
+			field.getNeighbors(previewCells, nHoverCell % field.getWidth(), nHoverCell / field.getWidth());
 		}
-		if (x > 0 && playfield[y * nSizeX + x - 1] > 0) { // West
-			if (getTileType(x - 1, y) == TileTypes::ZERO)
-				vec.push(std::make_pair(x - 1, y));
-			playfield[y * nSizeX + x - 1] = 0;
-			decrement();
+	}
+
+	// Update the solver with the changed cells
+	computeScores();
+	nRemainingShown.store(field.getRemainingCells(), std::memory_order_relaxed);
+}
+
+void Ottsweeper::logicLoop() {
+	while (true) {
+		// Apply all queued input and publish the tiles which changed
+		InputEvent event;
+		while (inputQueue.pop(event)) {
+			applyInput(event);
 		}
+		updateGame();
+		updateTiles();
+		nAppliedClick.store(nLastClick, std::memory_order_release);
+		if (bOnDemand) // Wake up the frame loop
+			glfwPostEmptyEvent();
+
+		// Wait for more input
+		std::unique_lock<std::mutex> lock(logicLock);
+		logicWake.wait(lock, [this]() { return (bStopLogic || !inputQueue.empty()); });
+		if (bStopLogic)
+			break;
 	}
 }
 
-void Ottsweeper::fillArea(const int& index) {
-	fillArea(index % nSizeX, index / nSizeX);
+void Ottsweeper::stopLogicThread() {
+	if (!logicThread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> guard(logicLock);
+		bStopLogic = true;
+	}
+	logicWake.notify_one();
+	logicThread.join();
 }
 
-void Ottsweeper::getNeighbors(std::vector<int>& vec, const int& x, const int& y) const {
-	vec.clear();
-	int xlow = std::max(0, x - 1);
-	int xhigh = std::min(nSizeX - 1, x + 1);
-	int ylow = std::max(0, y - 1);
-	int yhigh = std::min(nSizeY - 1, y + 1);
-	for (int yp = ylow; yp <= yhigh; yp++) {
-		for (int xp = xlow; xp <= xhigh; xp++) {
-			vec.push_back(yp * nSizeX + xp);
-		}
+void Ottsweeper::recordMove(const ReplayEvents& type, const int& cell) {
+	if (recordFile.empty() || bUnrecordedGame) // Moves made before the game was saved (or undone) are not known
+		return;
+	if (!recorder.isRecording() && !field.isFirstCell()) // Mines are placed by the first uncovered cell
+		recorder.begin(field, cell);
+	recorder.addEvent(field, type, cell, dGameTime);
+}
+
+void Ottsweeper::saveRecording() {
+	if (!recorder.isRecording())
+		return;
+	const size_t nEvents = recorder.getEventCount();
+	const size_t nBytes = recorder.getSize();
+	if (recorder.save(recordFile))
+		std::cout << " Recorded " << nEvents << " moves to " << recordFile << " (" << nBytes << " B)." << std::endl;
+}
+
+void Ottsweeper::saveSnapshot() {
+	if (snapshotFile.empty())
+		return;
+	if (gameState != GameStates::NORMAL || field.getState() != GameStates::NORMAL || field.isFirstCell()) { // Nothing to resume
+		std::remove(snapshotFile.c_str());
+		return;
 	}
+	if (Snapshot::save(snapshotFile, field, dTotalTime))
+		std::cout << " Saved unfinished game to " << snapshotFile << "." << std::endl;
 }
 
-bool Ottsweeper::getNeighbors(std::vector<int>& vec, const TileTypes& type, const int& x, const int& y) const {
-	vec.clear();
-	int xlow = std::max(0, x - 1);
-	int xhigh = std::min(nSizeX - 1, x + 1);
-	int ylow = std::max(0, y - 1);
-	int yhigh = std::min(nSizeY - 1, y + 1);
-	for (int yp = ylow; yp <= yhigh; yp++) {
-		for (int xp = xlow; xp <= xhigh; xp++) {
-			if (getTileType(xp, yp) == type)
-				vec.push_back(yp * nSizeX + xp);
-		}
+void Ottsweeper::updateReplay() {
+	while (player.getPosition() < player.getEventCount() && player.getNextEventTime() <= dTotalTime) {
+		if (!player.step(field))
+			break;
 	}
-	return !vec.empty();
 }
 
-void Ottsweeper::uncoverCell(const int& x, const int& y) {
-	uncoverCell(y * nSizeX + x);
+void Ottsweeper::computeScores() {
+	solver.update(field);
 }
 
-void Ottsweeper::uncoverCell(const int& cell) {
-	if (bFirstCell) {
-		placeBombs(cell);
-		bFirstCell = false;
+void Ottsweeper::computeProbabilities() {
+	if (bEndless || field.isFirstCell() || field.getState() != GameStates::NORMAL)
+		return;
+	if (!probabilities.compute(field, solver)) {
+		std::cout << " Error! No mine arrangement is consistent with the minefield." << std::endl;
+		return;
 	}
-	switch (getTileType(cell)) {
-	case TileTypes::ZERO: // Blank space (no surrounding mines)
-		fillArea(cell);
-		decrement();
-		break;
-	case TileTypes::BOMB: // KABOOM
-		setTileType(cell, TileTypes::EXPLOSION);
-		endGame(false);
-		break;
-	default:
-		decrement();
-		break;
+	const std::vector<ComponentInfo>& components = probabilities.getComponents();
+	std::cout << " Probabilities: " << components.size() << " components, " << probabilities.getTime() * 1E3 << " ms (" << probabilities.getThreadCount() << " threads)" << std::endl;
+	for (auto component = components.begin(); component != components.end(); component++) {
+		std::cout << "  " << component->nCells << " cells, " << component->nConstraints << " constraints, " << component->nSolutions << " solutions, ";
+		std::cout << component->nTasks << " tasks, " << component->dWallTime * 1E3 << " ms (" << component->dCpuTime * 1E3 << " ms cpu)" << std::endl;
 	}
-	playfield[cell] = 0;
+	std::cout << "  Other cells: " << 100 * probabilities.getOtherProbability() << "%" << std::endl;
+	printScores();
 }
 
-void Ottsweeper::decrement() {
-	if (--nRemainingCells == 0) {
-		endGame(true);
+void Ottsweeper::printScores() const {
+	if (bEndless) {
+		std::cout << " Hints are not available for endless minefields." << std::endl;
+		return;
+	}
+	const CellSet& safeCells = solver.getSafeCells();
+	std::cout << " Solver: " << safeCells.size() << " safe cells, " << solver.getMineCells().size() << " mines found (" << solver.getFrontier().size() << " unknown frontier cells)." << std::endl;
+	for (auto cell = safeCells.begin(); cell != safeCells.end(); cell++) {
+		std::cout << "  Safe: (" << *cell % field.getWidth() << ", " << *cell / field.getWidth() << ")" << std::endl;
+	}
+	if (safeCells.empty() && !probabilities.getProbabilities().empty()) { // Suggest the best guess
+		const int safest = probabilities.getSafestCell(field);
+		if (safest >= 0)
+			std::cout << "  Best guess: (" << safest % field.getWidth() << ", " << safest / field.getWidth() << "), " << 100 * probabilities.getProbability(safest) << "% mine" << std::endl;
 	}
 }
 
-void Ottsweeper::drawNumber(const int& x, const int& y, const int& value) {
-	// ones = value % 10
-	// tens = value / 10 (or value % 100 for value > 99)
-	// hund = value / 100 (or value % 1000 for value > 999)
-	if (value < 10) {
-		digits[0].drawCorner(x, y);
-		digits[0].drawCorner(x + 13, y);
-		digits[value % 10].drawCorner(x + 26, y);
-	}
-	else if (value < 100) {
-		digits[0].drawCorner(x, y);
-		digits[value / 10].drawCorner(x + 13, y);
-		digits[value % 10].drawCorner(x + 26, y);
-	}
-	else if (value < 1000) {
-		digits[value / 100].drawCorner(x, y);
-		digits[value % 100].drawCorner(x + 13, y);
-		digits[value % 10].drawCorner(x + 26, y);
-	}
-	else { // Overflow, print 999
-		for (int i = 0; i < 3; i++) {
-			digits[9].drawCorner(x + i * 13, y);
+void Ottsweeper::updateTiles() {
+	view.update(field, nPressedCell, previewCells);
+	field.clearChanges();
+	if (view.isFullRedraw()) { // Update every tile
+		for (int i = 0; i < field.getCells(); i++) {
+			setTile(i, view.getTile(i));
 		}
 	}
+	else { // Only update tiles which changed
+		const std::vector<int>& dirtyCells = view.getDirtyCells();
+		for (auto cell = dirtyCells.begin(); cell != dirtyCells.end(); cell++) {
+			setTile(*cell, view.getTile(*cell));
+		}
+	}
+	view.clearDirty();
 }
 
-void Ottsweeper::drawTile(const int& x, const int& y, const TileTypes& type) {
-	tiles[gridMap[type]].drawCorner(nMinefieldOffsetX + x * 16, nMinefieldOffsetY + y * 16);
+void Ottsweeper::setTile(const int& cell, const unsigned char& tile) {
+	if (!bInputThread) {
+		showTile(cell, tile);
+		return;
+	}
+	const TileUpdate update = { cell, tile };
+	while (!tileQueue.push(update) && !bStopLogic) { // Queue is full, wait for the frame loop to catch up
+		if (bOnDemand)
+			glfwPostEmptyEvent();
+		std::this_thread::yield();
+	}
 }
 
-void Ottsweeper::drawTile(const int& x, const int& y, const unsigned char& type) {
-	tiles[type].drawCorner(nMinefieldOffsetX + x * 16, nMinefieldOffsetY + y * 16);
+void Ottsweeper::showTile(const int& cell, const unsigned char& tile) {
+	shownTiles[cell] = tile;
+	const int col = cell % field.getWidth() - nFirstColumn;
+	const int row = cell / field.getWidth() - nFirstRow;
+	if (col >= 0 && row >= 0 && col < nGridColumns && row < nGridRows)
+		batch.setTile(row * nGridColumns + col, tile);
 }
 
-void Ottsweeper::generateBackground() {
-	const ColorRGB Gray1(192 / 255.f);
-	const ColorRGB Gray2(128 / 255.f);
-	const ColorRGB Gray3(109 / 255.f);
+void Ottsweeper::moveCamera(const int& dx, const int& dy, const int& zoom) {
+	// Zoom about the center of the window
+	const int nCenterX = nCameraX + unscaleView(nViewColumns * 8, nZoom);
+	const int nCenterY = nCameraY + unscaleView(nViewRows * 8, nZoom);
+	nZoom = std::max(nMinZoom, std::min(2, nZoom + zoom));
+	nCameraX = nCenterX - unscaleView(nViewColumns * 8, nZoom) + dx;
+	nCameraY = nCenterY - unscaleView(nViewRows * 8, nZoom) + dy;
 
-	// Borders:
-	// 255 White
-	// 192 Gray1
-	// 128 Gray2
-	// 109 Gray3
-	// Vertical borders: 3 pixels of White, 6 pixels of Gray, 3 pixels of Dark Gray
-	// Horizontal borders: 3 pixels of White, 5 pixels of Gray, 3 pixels of Dark Gray
-	OTTTexture bg(nNativeWidth, nNativeHeight, "background", Gray1);
-	
-	// Background layer
-	bg.setDrawColor(Gray1);
-	bg.drawRectangle(0, 0, nNativeWidth - 1, nNativeHeight - 1, true);
+	// Keep the window inside the minefield
+	nCameraX = std::max(0, std::min(field.getWidth() * 16 + nRowShift - unscaleView(nViewColumns * 16 + nRowShift, nZoom), nCameraX));
+	nCameraY = std::max(0, std::min(field.getHeight() * 16 - unscaleView(nViewRows * 16, nZoom), nCameraY));
+
+	// Cells drawn by the tile batch (the grid only changes size when zooming)
+	int nCols = 0;
+	int nRows = 0;
+	getGridSize(nZoom, nCols, nRows);
+	const int nFirstX = std::min(nCameraX / 16, field.getWidth() - nCols);
+	const int nFirstY = std::min(nCameraY / 16, field.getHeight() - nRows);
+	const bool bResized = (nCols != nGridColumns || nRows != nGridRows);
+	if (bResized) {
+		nGridColumns = nCols;
+		nGridRows = nRows;
+		batch.setGrid(nMinefieldOffsetX, nMinefieldOffsetY, nGridColumns, nGridRows, 16);
+	}
+	if (bResized || nFirstX != nFirstColumn || nFirstY != nFirstRow) { // Refill the tile batch
+		nFirstColumn = nFirstX;
+		nFirstRow = nFirstY;
+		for (int j = 0; j < nGridRows; j++) {
+			for (int i = 0; i < nGridColumns; i++) {
+				batch.setTile(j * nGridColumns + i, shownTiles[(nFirstRow + j) * field.getWidth() + nFirstColumn + i]);
+			}
+		}
+	}
+	batch.setGridView(nCameraX - 16 * nFirstColumn, nCameraY - 16 * nFirstRow, (nZoom >= 0 ? (float)(1 << nZoom) : 1.f / (1 << -nZoom)), nViewColumns * 16 + nRowShift, nViewRows * 16);
+	batch.setRowShift(nRowShift, nFirstRow);
+	requestRedraw();
+}
+
+void Ottsweeper::getGridSize(const int& zoom, int& cols, int& rows) const {
+	// Plus one cell for the partly visible cells at the edges of the window
+	cols = std::min(field.getWidth(), (unscaleView(nViewColumns * 16, zoom) + 15) / 16 + 1);
+	rows = std::min(field.getHeight(), (unscaleView(nViewRows * 16, zoom) + 15) / 16 + 1);
+}
+
+void Ottsweeper::handleEndlessInput() {
+	const long long x = nViewX + nCurrentCellX;
+	const long long y = nViewY + nCurrentCellY;
+	if (mouse.check(0)) { // LMB pressed
+		bLeftClickHeld = true;
+	}
+	else if (mouse.released(0)) { // LMB released
+		if (endless.getCover(x, y) == 0) { // Uncovered cell
+			if (mouse.check(1)) { // Right mouse button is being held
+				endless.chordCell(x, y);
+			}
+		}
+		else if (endless.getCover(x, y) != 2) { // Cell currently hidden (but not flagged)
+			endless.uncoverCell(x, y);
+		}
+	}
+	if (mouse.check(1)) { // RMB held
+		if (endless.getCover(x, y) == 0) { // Cell is uncovered
+			// The window is the same size as the (unused) fixed minefield, so use it to find neighboring window cells
+			field.getNeighbors(previewCells, nCurrentCellX, nCurrentCellY);
+		}
+	}
+	else if (mouse.released(1)) { // RMB released
+		endless.cycleFlag(x, y);
+	}
+}
+
+void Ottsweeper::updateEndlessTiles() {
+	// Only the cells inside the window are looked up, so the cost does not depend on how much has been explored.
+	// Nothing is looked up unless a cell, the view, or the pressed cells changed, and tiles which did not change
+	// are skipped by the batch.
+	const int pressedCell = (bLeftClickHeld ? nCurrentCell : -1);
+	std::sort(previewCells.begin(), previewCells.end()); // Matched in window order below
+	if (endless.getRevision() == nDrawnRevision && nViewX == nDrawnViewX && nViewY == nDrawnViewY && pressedCell == nDrawnPressedCell && previewCells == drawnPreviewCells)
+		return;
+	nDrawnRevision = endless.getRevision();
+	nDrawnViewX = nViewX;
+	nDrawnViewY = nViewY;
+	nDrawnPressedCell = pressedCell;
+	drawnPreviewCells.assign(previewCells.begin(), previewCells.end());
+	auto preview = previewCells.begin();
+	for (int j = 0; j < field.getHeight(); j++) { // Over window rows
+		for (int i = 0; i < field.getWidth(); i++) { // Over window columns
+			const int index = j * field.getWidth() + i;
+			const long long x = nViewX + i;
+			const long long y = nViewY + j;
+			const unsigned char cover = endless.getCover(x, y);
+			bool highlighted = (index == pressedCell);
+			if (preview != previewCells.end() && *preview == index) {
+				highlighted = true;
+				preview++;
+			}
+			batch.setTile(index, TileView::selectTile(cover, (cover == 0 ? endless.getCell(x, y) : 0), highlighted));
+		}
+	}
+}
+
+void Ottsweeper::layoutBackground() {
+	background.clear();
+	background.setScreenSize(nNativeWidth, nNativeHeight);
+	background.addPanel(0, 0, nNativeWidth - 1, nNativeHeight - 1, true); // Window
+	background.addPanel(9, 8, nNativeWidth - 10, 45, false); // Header
+	background.addPanel(9, 51, nNativeWidth - 10, nNativeHeight - 9, false); // Minefield
 
 	// Counter backgrounds
-	bg.setDrawColor(Colors::BLACK);
-	bg.drawRectangle(16, 15, 54, 37, true); // Score
-	bg.drawRectangle(nNativeWidth - 55, 15, nNativeWidth - 17, 37, true); // Time
-
-	// White borders
-	bg.setDrawColor(Colors::WHITE);
-	bg.drawLine(0, 0, 0, nNativeHeight - 2); // Left
-	bg.drawLine(1, 0, 1, nNativeHeight - 3); // Left
-	bg.drawLine(2, 0, 2, nNativeHeight - 4); // Left
-	bg.drawLine(3, 0, nNativeWidth - 2, 0); // Top
-	bg.drawLine(3, 1, nNativeWidth - 3, 1); // Top
-	bg.drawLine(3, 2, nNativeWidth - 4, 2); // Top
-	bg.drawLine(nNativeWidth - 10, 9, nNativeWidth - 10, 45); // Right of header
-	bg.drawLine(nNativeWidth - 11, 10, nNativeWidth - 11, 45); // Right of header
-	bg.drawLine(nNativeWidth - 12, 11, nNativeWidth - 12, 45); // Right of header
-	bg.drawLine(11, 43, nNativeWidth - 13, 43); // Bottom of header
-	bg.drawLine(10, 44, nNativeWidth - 13, 44); // Bottom of header
-	bg.drawLine(9, 45, nNativeWidth - 13, 45); // Bottom of header
-	bg.drawLine(nNativeWidth - 10, 52, nNativeWidth - 10, nNativeHeight - 9); // Right of minefield
-	bg.drawLine(nNativeWidth - 11, 53, nNativeWidth - 11, nNativeHeight - 9); // Right of minefield
-	bg.drawLine(nNativeWidth - 12, 54, nNativeWidth - 12, nNativeHeight - 9); // Right of minefield
-	bg.drawLine(11, nNativeHeight - 11, nNativeWidth - 13, nNativeHeight - 11); // Bottom of minefield
-	bg.drawLine(10, nNativeHeight - 10, nNativeWidth - 13, nNativeHeight - 10); // Bottom of minefield
-	bg.drawLine(9, nNativeHeight - 9, nNativeWidth - 13, nNativeHeight - 9); // Bottom of minefield
-
-	// Gray borders
-	bg.setDrawColor(Gray2);
-	bg.drawLine(nNativeWidth - 1, 1, nNativeWidth - 1, nNativeHeight - 1); // Right
-	bg.drawLine(nNativeWidth - 2, 2, nNativeWidth - 2, nNativeHeight - 1); // Right
-	bg.drawLine(nNativeWidth - 3, 3, nNativeWidth - 3, nNativeHeight - 1); // Right
-	bg.drawLine(1, nNativeHeight - 1, nNativeWidth - 4, nNativeHeight - 1); // Bottom
-	bg.drawLine(2, nNativeHeight - 2, nNativeWidth - 4, nNativeHeight - 2); // Bottom
-	bg.drawLine(3, nNativeHeight - 3, nNativeWidth - 4, nNativeHeight - 3); // Bottom
-	bg.drawLine(9, 8, 9, 44); // Left of header
-	bg.drawLine(10, 8, 10, 43); // Left of header
-	bg.drawLine(11, 8, 11, 42); // Left of header
-	bg.drawLine(12, 8, nNativeWidth - 10, 8); // Top of header
-	bg.drawLine(12, 9, nNativeWidth - 11, 9); // Top of header
-	bg.drawLine(12, 10, nNativeWidth - 12, 10); // Top of header
-	bg.drawLine(9, 51, 9, nNativeHeight - 10); // Left of minefield
-	bg.drawLine(10, 51, 10, nNativeHeight - 11); // Left of minefield
-	bg.drawLine(11, 51, 11, nNativeHeight - 12); // Left of minefield
-	bg.drawLine(12, 51, nNativeWidth - 10, 51); // Top of minefield
-	bg.drawLine(12, 52, nNativeWidth - 11, 52); // Top of minefield
-	bg.drawLine(12, 53, nNativeWidth - 12, 53); // Top of minefield
-
-	nBackgroundContext = OTTTexture::generateTextureRGBA(nNativeWidth, nNativeHeight, bg.get(), false); // Generate RGBA OpenGL texture
+	background.addRectangle(16, 15, 54, 37, 0.f, 0.f, 0.f); // Score
+	background.addRectangle(nNativeWidth - 55, 15, nNativeWidth - 17, 37, 0.f, 0.f, 0.f); // Time
 }
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,657 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#include "minefield.hpp"
+#include "tileview.hpp"
+#include "solver.hpp"
+#include "alloccount.hpp"
+#include "replay.hpp"
+#include "splitmix.hpp"
+
+struct BenchBoard {
+	std::string name;
+
+	int nWidth;
+
+	int nHeight;
+
+	int nMines;
+};
+
+struct BenchResult {
+	std::string name;
+
+	const BenchBoard* board;
+
+	unsigned long long nIterations;
+
+	unsigned long long nItems; // Number of operations timed (cells, moves, frames, ...)
+
+	double dSeconds; // Time spent in timed code
+};
+
+// Stand-in for the instanced tile batch, keeps the sprite of every cell and a list of modified instances
+class MockBatch {
+public:
+	MockBatch() :
+		instances(),
+		dirtyInstances()
+	{
+	}
+
+	void setGrid(const int& nCells) {
+		instances.assign(nCells, 0);
+		dirtyInstances.clear();
+		dirtyInstances.reserve(nCells);
+	}
+
+	void setTile(const int& index, const unsigned char& sprite) {
+		if (instances[index] == sprite)
+			return;
+		instances[index] = sprite;
+		dirtyInstances.push_back(index);
+	}
+
+	// Pretend to upload the modified instances
+	size_t draw() {
+		const size_t nUploads = dirtyInstances.size();
+		dirtyInstances.clear();
+		return nUploads;
+	}
+
+private:
+	std::vector<unsigned char> instances;
+
+	std::vector<int> dirtyInstances;
+};
+
+class BenchRunner {
+public:
+	BenchRunner() :
+		dMinTime(0.1),
+		filter(),
+		results()
+	{
+	}
+
+	void setMinTime(const double& seconds) {
+		dMinTime = seconds;
+	}
+
+	void setFilter(const std::string& name) {
+		filter = name;
+	}
+
+	const std::vector<BenchResult>& getResults() const {
+		return results;
+	}
+
+	// Repeat an untimed setup and a timed operation (which returns the number of items it processed)
+	// until the minimum time has been spent in the operation
+	template <typename Setup, typename Operation>
+	void run(const std::string& name, const BenchBoard& board, Setup setup, Operation operation) {
+		if (!filter.empty() && name.find(filter) == std::string::npos)
+			return;
+		BenchResult result = { name, &board, 0, 0, 0 };
+		auto wallStart = std::chrono::steady_clock::now();
+		while (result.nIterations < 3 || result.dSeconds < dMinTime) {
+			setup();
+			auto start = std::chrono::steady_clock::now();
+			result.nItems += operation();
+			auto stop = std::chrono::steady_clock::now();
+			result.dSeconds += std::chrono::duration<double>(stop - start).count();
+			result.nIterations++;
+			if (std::chrono::duration<double>(stop - wallStart).count() > 10 * dMinTime) // Setup is too slow
+				break;
+		}
+		results.push_back(result);
+		std::cerr << "  " << std::left << std::setw(16) << name << std::setw(14) << board.name << std::right << std::setw(14) << std::fixed << std::setprecision(2);
+		std::cerr << getNanoseconds(result) << " ns/item" << std::endl;
+	}
+
+	static double getNanoseconds(const BenchResult& result) {
+		return (result.nItems > 0 ? 1E9 * result.dSeconds / result.nItems : 0);
+	}
+
+private:
+	double dMinTime;
+
+	std::string filter;
+
+	std::vector<BenchResult> results;
+};
+
+void help(const char* name) {
+	std::cout << " Usage: " << name << " [options]" << std::endl;
+	std::cout << "  -t <seconds>  Minimum time spent in each benchmark (default 0.1)" << std::endl;
+	std::cout << "  -b <name>     Only run benchmarks whose name contains a string" << std::endl;
+	std::cout << "  -f <format>   Output format (table, csv, json)" << std::endl;
+	std::cout << "  -o <file>     Write results to a file instead of stdout" << std::endl;
+	std::cout << "  -c <cols>     Add a custom board with a number of columns" << std::endl;
+	std::cout << "  -r <rows>     Number of rows of the custom board" << std::endl;
+	std::cout << "  -m <mines>    Number of mines on the custom board" << std::endl;
+	std::cout << "  -q            Only benchmark the built-in difficulty levels" << std::endl;
+	std::cout << "  -z            Check that frames do not allocate instead of benchmarking (needs ENABLE_ALLOC_COUNT)" << std::endl;
+	std::cout << "  -S <seed>     Seed of the boards and moves (random by default)" << std::endl;
+	std::cout << "  -x            Check that torus cascades match square cascades instead of benchmarking" << std::endl;
+}
+
+// Reveal every safe cell in a random order, returns the number of moves
+unsigned long long revealAll(Minefield& field, const std::vector<int>& order) {
+	unsigned long long nMoves = 0;
+	for (auto cell = order.begin(); cell != order.end() && field.getState() == GameStates::NORMAL; cell++) {
+		if (field.getCover(*cell) == 1) {
+			field.uncoverCell(*cell);
+			nMoves++;
+		}
+	}
+	return nMoves;
+}
+
+void runBoard(BenchRunner& runner, const BenchBoard& board, SplitMix& rng) {
+	Minefield field(board.nWidth, board.nHeight, board.nMines);
+	field.setSeed(rng.next());
+	const int nCells = field.getCells();
+	const int center = (board.nHeight / 2) * board.nWidth + board.nWidth / 2;
+
+	// Fixed mine layout used by every benchmark which plays moves
+	field.resetField();
+	field.placeBombs(center);
+	std::vector<int> layout;
+	for (int i = 0; i < nCells; i++) {
+		if (field.isBomb(i % board.nWidth, i / board.nWidth))
+			layout.push_back(i);
+	}
+	auto resetLayout = [&]() {
+		field.resetField();
+		field.setMines(layout);
+		field.clearChanges();
+	};
+
+	// Safe cells in a random order
+	std::vector<int> order;
+	for (int i = 0; i < nCells; i++) {
+		if (!field.isBomb(i % board.nWidth, i / board.nWidth))
+			order.push_back(i);
+	}
+	for (size_t i = order.size(); i > 1; i--) {
+		std::swap(order[i - 1], order[rng.next((int)i)]);
+	}
+
+	// Mine placement and neighbor counting
+	runner.run("placeBombs", board,
+		[&]() { field.resetField(); },
+		[&]() { field.placeBombs(center); return 1ULL; });
+
+	// Zero cascade (fillArea) from a blank cell on a board with a tenth of the mines, per revealed cell
+	Minefield sparse(board.nWidth, board.nHeight, std::max(1, board.nMines / 10));
+	sparse.setSeed(rng.next());
+	sparse.placeBombs(center);
+	std::vector<int> sparseLayout;
+	int blankCell = center;
+	for (int i = 0; i < nCells; i++) {
+		if (sparse.isBomb(i % board.nWidth, i / board.nWidth))
+			sparseLayout.push_back(i);
+		else if (sparse.getTileType(i) == TileTypes::ZERO && sparse.getTileType(blankCell) != TileTypes::ZERO)
+			blankCell = i;
+	}
+	runner.run("fillArea", board,
+		[&]() {
+			sparse.resetField();
+			sparse.setMines(sparseLayout);
+			sparse.clearChanges();
+		},
+		[&]() {
+			sparse.uncoverCell(blankCell);
+			return (unsigned long long)(sparse.getCells() - sparse.getBombs() - sparse.getRemainingCells());
+		});
+
+	// Reveal every safe cell one at a time, per move
+	runner.run("uncoverCell", board,
+		resetLayout,
+		[&]() { return revealAll(field, order); });
+
+	// Chord every numbered cell once all mines are flagged, per chord
+	std::vector<int> numbered;
+	runner.run("chordCell", board,
+		[&]() {
+			resetLayout();
+			for (auto mine = layout.begin(); mine != layout.end(); mine++) {
+				field.cycleFlag(*mine);
+			}
+			numbered.clear();
+			for (int i = 0; i < nCells; i += 3) { // Uncover every third numbered cell, the rest are revealed by chording
+				const TileTypes type = field.getTileType(i);
+				if (type != TileTypes::ZERO && type != TileTypes::BOMB && field.getCover(i) == 1) {
+					field.uncoverCell(i);
+					numbered.push_back(i);
+				}
+			}
+			field.clearChanges();
+		},
+		[&]() {
+			for (auto cell = numbered.begin(); cell != numbered.end(); cell++) {
+				field.chordCell(*cell % board.nWidth, *cell / board.nWidth);
+			}
+			return (unsigned long long)std::max<size_t>(1, numbered.size());
+		});
+
+	// Tile type lookup of every cell, per cell
+	volatile int sink = 0;
+	resetLayout();
+	runner.run("getTileType", board,
+		[]() {},
+		[&]() {
+			int total = 0;
+			for (int i = 0; i < nCells; i++) {
+				total += (int)field.getTileType(i);
+			}
+			sink = sink + total;
+			return (unsigned long long)nCells;
+		});
+
+	// Neighbors of every cell, per cell
+	std::vector<int> neighbors;
+	runner.run("getNeighbors", board,
+		[]() {},
+		[&]() {
+			size_t total = 0;
+			for (int y = 0; y < board.nHeight; y++) {
+				for (int x = 0; x < board.nWidth; x++) {
+					field.getNeighbors(neighbors, x, y);
+					total += neighbors.size();
+				}
+			}
+			sink = sink + (int)total;
+			return (unsigned long long)nCells;
+		});
+
+	// Bit-plane neighbor counting kernel, per cell
+	std::vector<unsigned char> counts;
+	runner.run("countNeighbors", board,
+		[]() {},
+		[&]() {
+			field.getMinePlane().countNeighbors(counts, 9);
+			return (unsigned long long)nCells;
+		});
+
+	// Frame path: one move per frame, the tile view diff, and the (mock) batch update, per frame
+	TileView view;
+	MockBatch batch;
+	const std::vector<int> noPreview;
+	auto updateFrame = [&](const int& pressedCell) {
+		view.update(field, pressedCell, noPreview);
+		field.clearChanges();
+		if (view.isFullRedraw()) {
+			for (int i = 0; i < nCells; i++) {
+				batch.setTile(i, view.getTile(i));
+			}
+		}
+		else {
+			const std::vector<int>& dirtyCells = view.getDirtyCells();
+			for (auto cell = dirtyCells.begin(); cell != dirtyCells.end(); cell++) {
+				batch.setTile(*cell, view.getTile(*cell));
+			}
+		}
+		view.clearDirty();
+		return batch.draw();
+	};
+	runner.run("frameMove", board,
+		[&]() {
+			resetLayout();
+			batch.setGrid(nCells);
+			view.invalidate();
+			updateFrame(-1);
+		},
+		[&]() {
+			unsigned long long nFrames = 0;
+			for (auto cell = order.begin(); cell != order.end() && field.getState() == GameStates::NORMAL; cell++) {
+				if (field.getCover(*cell) != 1)
+					continue;
+				field.uncoverCell(*cell);
+				updateFrame(*cell);
+				nFrames++;
+			}
+			return nFrames;
+		});
+
+	// Frame path with nothing changing but the pressed cell, per frame
+	runner.run("frameIdle", board,
+		[&]() {
+			resetLayout();
+			batch.setGrid(nCells);
+			view.invalidate();
+			updateFrame(-1);
+		},
+		[&]() {
+			for (int i = 0; i < 1000; i++) {
+				updateFrame(order[i % order.size()]);
+			}
+			return 1000ULL;
+		});
+}
+
+// Play games one move per frame, the same way the game loop does (with undo history and a replay being
+// recorded), and count heap allocations made by every frame after the first game. Return false if any
+// frame allocated.
+bool checkAllocations(const BenchBoard& board, SplitMix& rng) {
+	Minefield field(board.nWidth, board.nHeight, board.nMines);
+	field.setSeed(rng.next());
+	field.setHistoryEnabled(true);
+	ReplayWriter recorder;
+	double dGameTime = 0;
+	Solver solver;
+	TileView view;
+	MockBatch batch;
+	const int nCells = field.getCells();
+	batch.setGrid(nCells);
+	std::vector<int> previewCells;
+	previewCells.reserve(9);
+
+	// Cells in a random order
+	std::vector<int> order;
+	for (int i = 0; i < nCells; i++) {
+		order.push_back(i);
+	}
+
+	// Record a move the way the game does
+	auto record = [&](const ReplayEvents& type, const int& cell) {
+		if (!recorder.isRecording() && !field.isFirstCell())
+			recorder.begin(field, cell);
+		recorder.addEvent(field, type, cell, dGameTime);
+	};
+
+	// Reveal, flag, or chord a cell and draw the frame
+	auto playFrame = [&](const int& cell) {
+		const int x = cell % board.nWidth;
+		const int y = cell / board.nWidth;
+		const unsigned char cover = field.getCover(cell);
+		dGameTime += 0.016;
+		previewCells.clear();
+		if (cover == 0) { // Show neighbors, then chord
+			field.getNeighbors(previewCells, x, y);
+			if (field.chordCell(x, y))
+				record(ReplayEvents::CHORD, cell);
+		}
+		else if (field.isFirstCell() || !field.isBomb(x, y) || rng.next(64) == 0) { // Mostly avoid mines, to play longer games
+			if (cover == 2) {
+				field.cycleFlag(cell);
+				record(ReplayEvents::FLAG, cell);
+			}
+			field.uncoverCell(cell);
+			record(ReplayEvents::REVEAL, cell);
+		}
+		else if (cover == 1) {
+			field.cycleFlag(cell);
+			record(ReplayEvents::FLAG, cell);
+		}
+		solver.update(field);
+		view.update(field, cell, previewCells);
+		field.clearChanges();
+		if (view.isFullRedraw()) {
+			for (int i = 0; i < nCells; i++) {
+				batch.setTile(i, view.getTile(i));
+			}
+		}
+		else {
+			const std::vector<int>& dirtyCells = view.getDirtyCells();
+			for (auto dirty = dirtyCells.begin(); dirty != dirtyCells.end(); dirty++) {
+				batch.setTile(*dirty, view.getTile(*dirty));
+			}
+		}
+		view.clearDirty();
+		batch.draw();
+	};
+
+	const int nGames = 6;
+	unsigned long long nFrames = 0;
+	unsigned long long nAllocations = 0;
+	unsigned long long nAllocatingFrames = 0;
+	for (int game = 0; game < nGames; game++) {
+		for (size_t i = order.size(); i > 1; i--) {
+			std::swap(order[i - 1], order[rng.next((int)i)]);
+		}
+		const unsigned long long nStart = AllocationCounter::getAllocations();
+		recorder.clear(); // The game writes the replay to disk when a game ends, which is not part of a frame
+		dGameTime = 0;
+		field.resetField();
+		for (int pass = 0; pass < 2 && field.getState() == GameStates::NORMAL; pass++) { // Second pass chords and clears flags
+			for (auto cell = order.begin(); cell != order.end() && field.getState() == GameStates::NORMAL; cell++) {
+				const unsigned long long nFrameStart = AllocationCounter::getAllocations();
+				playFrame(*cell);
+				if (game > 0) { // The first game is part of startup
+					const unsigned long long nFrameAllocations = AllocationCounter::getAllocations() - nFrameStart;
+					nAllocations += nFrameAllocations;
+					nAllocatingFrames += (nFrameAllocations > 0 ? 1 : 0);
+					nFrames++;
+				}
+			}
+		}
+		if (game > 0) // Include the reset at the start of the game
+			nAllocations += AllocationCounter::getAllocations() - nStart;
+	}
+	std::cout << "  " << std::left << std::setw(14) << board.name << std::right << std::setw(10) << nFrames << " frames, ";
+	std::cout << nAllocations << " allocations in " << nAllocatingFrames << " frames" << std::endl;
+	return (nAllocations == 0);
+}
+
+// Play the same games on a square and a torus minefield, and compare the cells uncovered by every move. The
+// edges of both minefields are mined, so that no number or cascade depends on the cells across the wrap edges
+// of the torus. Return false if the minefields differ.
+bool checkCascades(SplitMix& rng) {
+	const int nSize = 64;
+	const int nGames = 20;
+	const int nCells = nSize * nSize;
+	bool bSuccess = true;
+	unsigned long long nMoves = 0;
+	for (int game = 0; game < nGames && bSuccess; game++) {
+		std::vector<int> layout;
+		std::vector<int> order;
+		for (int cell = 0; cell < nCells; cell++) {
+			const int x = cell % nSize;
+			const int y = cell / nSize;
+			if (x == 0 || y == 0 || x == nSize - 1 || y == nSize - 1 || rng.next(100) < 8)
+				layout.push_back(cell);
+			else
+				order.push_back(cell);
+		}
+		for (size_t i = order.size(); i > 1; i--) {
+			std::swap(order[i - 1], order[rng.next((int)i)]);
+		}
+		Minefield square(nSize, nSize, (int)layout.size());
+		Minefield torus(nSize, nSize, (int)layout.size());
+		torus.setTopology(Topologies::TORUS);
+		square.setMines(layout);
+		torus.setMines(layout);
+		for (auto cell = order.begin(); cell != order.end() && bSuccess; cell++) {
+			if (square.getCover(*cell) != 1)
+				continue;
+			square.uncoverCell(*cell);
+			torus.uncoverCell(*cell);
+			nMoves++;
+			bSuccess = (square.getRemainingCells() == torus.getRemainingCells() && square.getState() == torus.getState());
+			for (int i = 0; i < nCells && bSuccess; i++) {
+				bSuccess = (square.getCover(i) == torus.getCover(i));
+			}
+		}
+	}
+	std::cout << "  " << nMoves << " moves on " << nSize << " x " << nSize << " minefields" << std::endl;
+	return bSuccess;
+}
+
+void writeResults(std::ostream& out, const std::vector<BenchResult>& results, const std::string& format) {
+	if (format == "csv") {
+		out << "benchmark,board,width,height,mines,iterations,items,seconds,ns_per_item" << std::endl;
+		for (auto result = results.begin(); result != results.end(); result++) {
+			out << result->name << "," << result->board->name << "," << result->board->nWidth << "," << result->board->nHeight << "," << result->board->nMines << ",";
+			out << result->nIterations << "," << result->nItems << "," << result->dSeconds << "," << BenchRunner::getNanoseconds(*result) << std::endl;
+		}
+	}
+	else if (format == "json") {
+		out << "[" << std::endl;
+		for (auto result = results.begin(); result != results.end(); result++) {
+			out << "  {\"benchmark\": \"" << result->name << "\", \"board\": \"" << result->board->name << "\", ";
+			out << "\"width\": " << result->board->nWidth << ", \"height\": " << result->board->nHeight << ", \"mines\": " << result->board->nMines << ", ";
+			out << "\"iterations\": " << result->nIterations << ", \"items\": " << result->nItems << ", \"seconds\": " << result->dSeconds << ", ";
+			out << "\"ns_per_item\": " << BenchRunner::getNanoseconds(*result) << "}" << (result + 1 != results.end() ? "," : "") << std::endl;
+		}
+		out << "]" << std::endl;
+	}
+	else { // Table
+		out << std::left << std::setw(16) << "Benchmark" << std::setw(14) << "Board" << std::right << std::setw(12) << "Iterations" << std::setw(16) << "ns/item" << std::endl;
+		for (auto result = results.begin(); result != results.end(); result++) {
+			out << std::left << std::setw(16) << result->name << std::setw(14) << result->board->name << std::right << std::setw(12) << result->nIterations;
+			out << std::setw(16) << std::fixed << std::setprecision(2) << BenchRunner::getNanoseconds(*result) << std::endl;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	BenchRunner runner;
+	std::string format = "table";
+	std::string outputPath;
+	bool bPresetsOnly = false;
+	bool bCheckAllocations = false;
+	bool bCheckCascades = false;
+	int nCustomX = 0;
+	int nCustomY = 0;
+	int nCustomMines = 0;
+	bool bSeeded = false;
+	uint64_t nSeed = 0;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg(argv[i]);
+		if (arg == "-h" || arg == "--help") {
+			help(argv[0]);
+			return 0;
+		}
+		if (arg == "-q") {
+			bPresetsOnly = true;
+			continue;
+		}
+		if (arg == "-z") {
+			bCheckAllocations = true;
+			continue;
+		}
+		if (arg == "-x") {
+			bCheckCascades = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cout << " Error! Missing argument to option " << arg << "." << std::endl;
+			return 1;
+		}
+		const char* value = argv[++i];
+		if (arg == "-t")
+			runner.setMinTime(std::atof(value));
+		else if (arg == "-b")
+			runner.setFilter(value);
+		else if (arg == "-f")
+			format = value;
+		else if (arg == "-o")
+			outputPath = value;
+		else if (arg == "-c")
+			nCustomX = std::atoi(value);
+		else if (arg == "-r")
+			nCustomY = std::atoi(value);
+		else if (arg == "-m")
+			nCustomMines = std::atoi(value);
+		else if (arg == "-S") {
+			nSeed = std::strtoull(value, 0, 10);
+			bSeeded = true;
+		}
+		else {
+			std::cout << " Error! Unknown option " << arg << "." << std::endl;
+			help(argv[0]);
+			return 1;
+		}
+	}
+	if (format != "table" && format != "csv" && format != "json") {
+		std::cout << " Error! Unknown output format (" << format << ")." << std::endl;
+		return 1;
+	}
+
+	// Built-in difficulty levels
+	std::vector<BenchBoard> boards;
+	for (unsigned int level = 0; level <= 8; level++) {
+		BenchBoard board;
+		std::stringstream stream;
+		stream << "difficulty" << level;
+		board.name = stream.str();
+		Minefield::getDifficulty(level, board.nWidth, board.nHeight, board.nMines);
+		boards.push_back(board);
+	}
+
+	// Giant boards (around expert density)
+	if (!bPresetsOnly) {
+		const BenchBoard giant[3] = {
+			{ "giant256", 256, 256, 13500 },
+			{ "giant1000", 1000, 1000, 206000 },
+			{ "giant3000", 3000, 3000, 1854000 }
+		};
+		boards.insert(boards.end(), giant, giant + 3);
+	}
+	if (nCustomX > 0 && nCustomY > 0) {
+		if (nCustomMines < 0 || nCustomMines >= nCustomX * nCustomY) {
+			std::cout << " Error! Invalid custom board (" << nCustomX << " x " << nCustomY << ", " << nCustomMines << " mines)." << std::endl;
+			return 1;
+		}
+		BenchBoard custom = { "custom", nCustomX, nCustomY, nCustomMines };
+		boards.push_back(custom);
+	}
+
+	// Every board and move order is drawn from one seed, so that failed checks can be repeated
+	if (!bSeeded)
+		nSeed = SplitMix::randomSeed();
+	std::cerr << " Random seed " << nSeed << std::endl;
+	SplitMix rng(SplitMix::split(nSeed, 0));
+
+	if (bCheckCascades) {
+		std::cout << " Checking torus cascades against square cascades" << std::endl;
+		const bool bSuccess = checkCascades(rng);
+		std::cout << (bSuccess ? " Passed" : " Failed! Cascades uncovered different cells.") << std::endl;
+		return (bSuccess ? 0 : 1);
+	}
+
+	if (bCheckAllocations) {
+		if (!AllocationCounter::isEnabled()) {
+			std::cout << " Error! Allocation counting is not enabled in this build (configure with ENABLE_ALLOC_COUNT)." << std::endl;
+			return 1;
+		}
+		std::cout << " Checking allocations during frames" << std::endl;
+		bool bSuccess = true;
+		for (auto board = boards.begin(); board != boards.end(); board++) {
+			if (board->nWidth * board->nHeight > 1000000) // Too slow to play one move per frame
+				continue;
+			if (!checkAllocations(*board, rng))
+				bSuccess = false;
+		}
+		std::cout << (bSuccess ? " Passed" : " Failed! Frames allocated after startup.") << std::endl;
+		return (bSuccess ? 0 : 1);
+	}
+
+	std::cerr << " Running benchmarks (" << BitPlane::getKernelName() << " neighbor counting kernel)" << std::endl;
+	for (auto board = boards.begin(); board != boards.end(); board++) {
+		runBoard(runner, *board, rng);
+	}
+
+	if (!outputPath.empty()) {
+		std::ofstream ofile(outputPath.c_str());
+		if (!ofile.good()) {
+			std::cout << " Error! Failed to open output file (" << outputPath << ")." << std::endl;
+			return 1;
+		}
+		writeResults(ofile, runner.getResults(), format);
+	}
+	else {
+		writeResults(std::cout, runner.getResults(), format);
+	}
+
+	return 0;
+}
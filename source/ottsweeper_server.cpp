@@ -0,0 +1,551 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+
+#include "minefield.hpp"
+#include "tileview.hpp"
+#include "splitmix.hpp"
+
+// Largest minefield a session may create
+const int maxSessionCells = 1 << 24;
+
+// Longest partial request kept while waiting for the rest of the line
+const size_t maxRequestLength = 256;
+
+// Stop reading requests from a client while this many reply bytes are waiting to be sent
+const size_t maxPendingOutput = 1 << 22;
+
+// Bytes read from a socket at once
+const size_t readChunkSize = 1 << 16;
+
+volatile std::sig_atomic_t bStopServer = 0;
+
+void stopServer(int) {
+	bStopServer = 1;
+}
+
+void help(const char* name) {
+	std::cout << " Usage: " << name << " [options]" << std::endl;
+	std::cout << "  -p <path>   Unix domain socket to listen on (default ottsweeper.sock)" << std::endl;
+	std::cout << "  -t <count>  Number of threads (default one per hardware thread)" << std::endl;
+	std::cout << "  -s <seed>   Seed of the session streams (random by default)" << std::endl;
+	std::cout << std::endl;
+	std::cout << " Every connection plays one game at a time. Requests are single lines, and may be" << std::endl;
+	std::cout << " pipelined (replies are sent in the same order):" << std::endl;
+	std::cout << "  N <cols> <rows> <mines> [seed]   Start a new game" << std::endl;
+	std::cout << "  R <x> <y>                        Reveal a cell" << std::endl;
+	std::cout << "  F <x> <y>                        Cycle the flag of a cell (flag, unknown, none)" << std::endl;
+	std::cout << "  C <x> <y>                        Chord a numbered cell" << std::endl;
+	std::cout << "  B                                Get the whole board" << std::endl;
+	std::cout << " Moves reply with the game state (P playing, W won, L lost), the number of covered safe" << std::endl;
+	std::cout << " cells, and the cells whose tile changed: \"P <remaining> <count> <cell> <tile> ...\"," << std::endl;
+	std::cout << " where cell = y * cols + x. Tiles are 0-8 (numbers), 9 (mine), 10 (exploded mine)," << std::endl;
+	std::cout << " 11 (wrong flag), 12 (covered), 13 (flag), and 14 (unknown). B replies with" << std::endl;
+	std::cout << " \"B <cols> <rows> <tiles>\", one hexadecimal digit per tile. Errors reply \"E <message>\"." << std::endl;
+}
+
+// Append a number to a reply
+void appendNumber(std::string& str, unsigned long long value) {
+	char digits[20];
+	int nDigits = 0;
+	do {
+		digits[nDigits++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	while (nDigits > 0) {
+		str.push_back(digits[--nDigits]);
+	}
+}
+
+// Parse the next number of a request, return false if there is none
+bool parseNumber(const char*& ptr, unsigned long long& value) {
+	while (*ptr == ' ' || *ptr == '\t') {
+		ptr++;
+	}
+	if (*ptr < '0' || *ptr > '9')
+		return false;
+	value = 0;
+	while (*ptr >= '0' && *ptr <= '9') {
+		value = value * 10 + (unsigned long long)(*ptr - '0');
+		ptr++;
+	}
+	return true;
+}
+
+// Return true if only whitespace is left in a request
+bool isEnd(const char* ptr) {
+	while (*ptr == ' ' || *ptr == '\t' || *ptr == '\r') {
+		ptr++;
+	}
+	return (*ptr == '\0');
+}
+
+// Game played over one client connection. Requests are handled in the order they were received, and their
+// replies are buffered and sent together once every complete request read from the socket has been handled.
+class Session {
+public:
+	Session(const int& socket, const uint64_t& seed) :
+		nSocket(socket),
+		nEvents(0),
+		nSeed(seed),
+		nGames(0),
+		nOutputSent(0),
+		field(),
+		tiles(),
+		changes(),
+		input(),
+		output()
+	{
+	}
+
+	~Session() {
+		::close(nSocket);
+	}
+
+	int getSocket() const {
+		return nSocket;
+	}
+
+	// Events the socket is registered for
+	unsigned int getEvents() const {
+		return nEvents;
+	}
+
+	void setEvents(const unsigned int& events) {
+		nEvents = events;
+	}
+
+	size_t getPendingOutput() const {
+		return output.size() - nOutputSent;
+	}
+
+	// Read and handle every available request, return false if the connection should be closed
+	bool receive(unsigned long long& moves);
+
+	// Send as many pending replies as the socket accepts, return false if the connection failed
+	bool send();
+
+private:
+	int nSocket;
+
+	unsigned int nEvents;
+
+	uint64_t nSeed; // Seed of the games of this session which were not given their own seed
+
+	unsigned long long nGames;
+
+	size_t nOutputSent; // Bytes at the front of the output which have already been sent
+
+	Minefield field;
+
+	std::vector<unsigned char> tiles; // Tiles last sent to the client (empty until a game is started)
+
+	std::vector<int> changes; // Cells whose tile changed since the last reply
+
+	std::string input;
+
+	std::string output;
+
+	void handleRequest(const char* request, unsigned long long& moves);
+
+	void newGame(const char* args);
+
+	void move(const char& type, const char* args);
+
+	// Reply with the game state and every tile which changed since the last reply
+	void replyChanges();
+
+	// Add a cell to the changed cells if its tile changed
+	void updateTile(const int& cell);
+
+	void replyBoard();
+
+	void replyError(const char* message);
+};
+
+bool Session::receive(unsigned long long& moves) {
+	char buffer[readChunkSize];
+	while (getPendingOutput() < maxPendingOutput) {
+		const ssize_t nRead = ::recv(nSocket, buffer, readChunkSize, 0);
+		if (nRead == 0) // Closed by the client
+			return false;
+		if (nRead < 0) {
+			if (errno == EINTR)
+				continue;
+			return (errno == EAGAIN || errno == EWOULDBLOCK);
+		}
+		input.append(buffer, nRead);
+
+		// Handle every complete request (the line is terminated in place so that it can be parsed directly)
+		size_t start = 0;
+		size_t end = 0;
+		while ((end = input.find('\n', start)) != std::string::npos) {
+			input[end] = '\0';
+			handleRequest(input.c_str() + start, moves);
+			start = end + 1;
+		}
+		input.erase(0, start);
+		if (input.size() > maxRequestLength) {
+			replyError("request too long");
+			send();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Session::send() {
+	while (nOutputSent < output.size()) {
+		const ssize_t nSent = ::send(nSocket, output.data() + nOutputSent, output.size() - nOutputSent, MSG_NOSIGNAL);
+		if (nSent >= 0) {
+			nOutputSent += nSent;
+		}
+		else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return true;
+		}
+		else if (errno != EINTR) {
+			return false;
+		}
+	}
+	output.clear();
+	nOutputSent = 0;
+	return true;
+}
+
+void Session::handleRequest(const char* request, unsigned long long& moves) {
+	while (*request == ' ' || *request == '\t') {
+		request++;
+	}
+	switch (*request) {
+	case 'N':
+		newGame(request + 1);
+		break;
+	case 'R':
+	case 'F':
+	case 'C':
+		move(*request, request + 1);
+		moves++;
+		break;
+	case 'B':
+		if (!isEnd(request + 1))
+			replyError("invalid request");
+		else
+			replyBoard();
+		break;
+	case '\0':
+	case '\r': // Empty line
+		break;
+	default:
+		replyError("unknown request");
+		break;
+	}
+}
+
+void Session::newGame(const char* args) {
+	unsigned long long width = 0;
+	unsigned long long height = 0;
+	unsigned long long mines = 0;
+	unsigned long long seed = 0;
+	if (!parseNumber(args, width) || !parseNumber(args, height) || !parseNumber(args, mines)) {
+		replyError("expected N <cols> <rows> <mines> [seed]");
+		return;
+	}
+	const bool bSeeded = parseNumber(args, seed);
+	if (!isEnd(args)) {
+		replyError("expected N <cols> <rows> <mines> [seed]");
+		return;
+	}
+	if (width == 0 || height == 0 || width > (unsigned long long)maxSessionCells || height > (unsigned long long)maxSessionCells ||
+	    width * height > (unsigned long long)maxSessionCells || mines >= width * height) {
+		replyError("invalid minefield size");
+		return;
+	}
+	field.setSize((int)width, (int)height, (int)mines);
+	field.setSeed(bSeeded ? (uint64_t)seed : SplitMix::split(nSeed, nGames));
+	field.clearChanges();
+	tiles.assign(field.getCells(), Minefield::getDefaultTileValue(TileTypes::NORMAL));
+	nGames++;
+	replyChanges();
+}
+
+void Session::move(const char& type, const char* args) {
+	unsigned long long x = 0;
+	unsigned long long y = 0;
+	if (!parseNumber(args, x) || !parseNumber(args, y) || !isEnd(args)) {
+		replyError("expected <R|F|C> <x> <y>");
+		return;
+	}
+	if (tiles.empty()) {
+		replyError("no game started");
+		return;
+	}
+	if (x >= (unsigned long long)field.getWidth() || y >= (unsigned long long)field.getHeight()) {
+		replyError("cell out of range");
+		return;
+	}
+	if (field.getState() == GameStates::NORMAL) { // Moves after the end of the game do nothing
+		const int cell = (int)y * field.getWidth() + (int)x;
+		const unsigned char cover = field.getCover(cell);
+		if (type == 'R' && cover != 0 && cover != 2) // Covered (but not flagged)
+			field.uncoverCell(cell);
+		else if (type == 'F' && cover != 0)
+			field.cycleFlag(cell);
+		else if (type == 'C' && cover == 0)
+			field.chordCell((int)x, (int)y);
+	}
+	replyChanges();
+}
+
+void Session::replyChanges() {
+	// Find the tiles which changed
+	changes.clear();
+	if (field.isFullUpdate()) { // Too many changes to list, compare every cell
+		for (int i = 0; i < field.getCells(); i++) {
+			updateTile(i);
+		}
+	}
+	else {
+		const std::vector<int>& changedCells = field.getChangedCells();
+		for (auto cell = changedCells.begin(); cell != changedCells.end(); cell++) {
+			updateTile(*cell);
+		}
+	}
+	field.clearChanges();
+
+	// Game state, remaining cells, and changed tiles
+	switch (field.getState()) {
+	case GameStates::WIN:
+		output.push_back('W');
+		break;
+	case GameStates::LOSS:
+		output.push_back('L');
+		break;
+	default:
+		output.push_back('P');
+		break;
+	}
+	output.push_back(' ');
+	appendNumber(output, (unsigned long long)field.getRemainingCells());
+	output.push_back(' ');
+	appendNumber(output, (unsigned long long)changes.size());
+	for (auto cell = changes.begin(); cell != changes.end(); cell++) {
+		output.push_back(' ');
+		appendNumber(output, (unsigned long long)*cell);
+		output.push_back(' ');
+		appendNumber(output, tiles[*cell]);
+	}
+	output.push_back('\n');
+}
+
+void Session::updateTile(const int& cell) {
+	const unsigned char tile = TileView::selectTile(field.getCover(cell), field.getCell(cell), false);
+	if (tile == tiles[cell])
+		return;
+	tiles[cell] = tile;
+	changes.push_back(cell);
+}
+
+void Session::replyBoard() {
+	if (tiles.empty()) {
+		replyError("no game started");
+		return;
+	}
+	const char hexDigits[] = "0123456789abcdef";
+	output.append("B ");
+	appendNumber(output, (unsigned long long)field.getWidth());
+	output.push_back(' ');
+	appendNumber(output, (unsigned long long)field.getHeight());
+	output.push_back(' ');
+	for (int i = 0; i < field.getCells(); i++) {
+		tiles[i] = TileView::selectTile(field.getCover(i), field.getCell(i), false);
+		output.push_back(hexDigits[tiles[i] & 0xf]);
+	}
+	field.clearChanges();
+	output.push_back('\n');
+}
+
+void Session::replyError(const char* message) {
+	output.append("E ");
+	output.append(message);
+	output.push_back('\n');
+}
+
+struct ServerStatistics {
+	std::atomic<unsigned long long> nSessions;
+
+	std::atomic<unsigned long long> nMoves;
+};
+
+// Register a client socket for the events it needs, return false on error
+bool updateEvents(const int& epollSocket, Session& session) {
+	unsigned int events = EPOLLIN;
+	if (session.getPendingOutput() >= maxPendingOutput) // Wait for the client to read its replies
+		events = EPOLLOUT;
+	else if (session.getPendingOutput() > 0)
+		events |= EPOLLOUT;
+	if (events == session.getEvents())
+		return true;
+	epoll_event event;
+	event.events = events;
+	event.data.ptr = &session;
+	const int operation = (session.getEvents() == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD);
+	session.setEvents(events);
+	return (epoll_ctl(epollSocket, operation, session.getSocket(), &event) == 0);
+}
+
+// Accept connections and handle their requests on the calling thread until the server is stopped. Every
+// thread waits on the listening socket, and each connection is served by the thread which accepted it.
+void serve(const int& listenSocket, const uint64_t& seed, ServerStatistics& stats) {
+	const int epollSocket = epoll_create1(EPOLL_CLOEXEC);
+	if (epollSocket < 0) {
+		std::cout << " Error! Failed to create epoll instance (" << std::strerror(errno) << ")." << std::endl;
+		return;
+	}
+	epoll_event listenEvent;
+	listenEvent.events = EPOLLIN | EPOLLEXCLUSIVE; // Only wake one thread for each new connection
+	listenEvent.data.ptr = 0x0;
+	if (epoll_ctl(epollSocket, EPOLL_CTL_ADD, listenSocket, &listenEvent) != 0) {
+		std::cout << " Error! Failed to wait on listening socket (" << std::strerror(errno) << ")." << std::endl;
+		::close(epollSocket);
+		return;
+	}
+
+	std::unordered_map<int, std::unique_ptr<Session> > sessions;
+	std::vector<epoll_event> events(256);
+	unsigned long long nSessions = 0;
+	unsigned long long nMoves = 0;
+	while (!bStopServer) {
+		const int nEvents = epoll_wait(epollSocket, events.data(), (int)events.size(), 100); // Check for a stop request every 100 ms
+		if (nEvents < 0) {
+			if (errno == EINTR)
+				continue;
+			std::cout << " Error! Failed to wait for events (" << std::strerror(errno) << ")." << std::endl;
+			break;
+		}
+		for (int i = 0; i < nEvents; i++) {
+			Session* session = (Session*)events[i].data.ptr;
+			if (!session) { // New connections
+				while (true) {
+					const int clientSocket = accept4(listenSocket, 0x0, 0x0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+					if (clientSocket < 0)
+						break;
+					std::unique_ptr<Session> client(new Session(clientSocket, SplitMix::split(seed, nSessions++)));
+					if (updateEvents(epollSocket, *client))
+						sessions[clientSocket] = std::move(client);
+				}
+				continue;
+			}
+			bool bOpen = true;
+			if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+				bOpen = session->receive(nMoves);
+			if (bOpen && session->getPendingOutput() > 0) // Send every reply of the batch together
+				bOpen = session->send();
+			if (bOpen) // Reading resumes once the client catches up with its replies
+				bOpen = updateEvents(epollSocket, *session);
+			if (!bOpen) { // Closing the socket removes it from the epoll instance
+				sessions.erase(session->getSocket());
+			}
+		}
+	}
+	sessions.clear();
+	::close(epollSocket);
+	stats.nSessions += nSessions;
+	stats.nMoves += nMoves;
+}
+
+int main(int argc, char* argv[]) {
+	std::string socketPath = "ottsweeper.sock";
+	unsigned int nThreads = 0;
+	bool bSeeded = false;
+	uint64_t nSeed = 0;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg(argv[i]);
+		if (arg == "-h" || arg == "--help") {
+			help(argv[0]);
+			return 0;
+		}
+		if (i + 1 >= argc) {
+			std::cout << " Error! Missing argument to option " << arg << "." << std::endl;
+			return 1;
+		}
+		const std::string value = argv[++i];
+		if (arg == "-p")
+			socketPath = value;
+		else if (arg == "-t")
+			nThreads = (unsigned int)std::strtoul(value.c_str(), 0, 10);
+		else if (arg == "-s") {
+			nSeed = std::strtoull(value.c_str(), 0, 10);
+			bSeeded = true;
+		}
+		else {
+			std::cout << " Error! Unknown option " << arg << "." << std::endl;
+			help(argv[0]);
+			return 1;
+		}
+	}
+	if (nThreads == 0)
+		nThreads = std::max(1U, std::thread::hardware_concurrency());
+	if (!bSeeded)
+		nSeed = SplitMix::randomSeed();
+
+	// Listen on the socket (replacing a socket left behind by a previous server)
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+		std::cout << " Error! Invalid socket path (" << socketPath << ")." << std::endl;
+		return 1;
+	}
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+	struct stat info;
+	if (stat(socketPath.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+		unlink(socketPath.c_str());
+	const int listenSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listenSocket < 0 || bind(listenSocket, (const sockaddr*)&address, sizeof(address)) != 0 || listen(listenSocket, SOMAXCONN) != 0) {
+		std::cout << " Error! Failed to listen on " << socketPath << " (" << std::strerror(errno) << ")." << std::endl;
+		if (listenSocket >= 0)
+			::close(listenSocket);
+		return 1;
+	}
+	std::signal(SIGINT, stopServer);
+	std::signal(SIGTERM, stopServer);
+	std::signal(SIGPIPE, SIG_IGN);
+	std::cout << " Listening on " << socketPath << " with " << nThreads << " threads (seed " << nSeed << ")." << std::endl;
+
+	// Serve clients until interrupted
+	auto startTime = std::chrono::steady_clock::now();
+	ServerStatistics stats;
+	stats.nSessions = 0;
+	stats.nMoves = 0;
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < nThreads; i++) {
+		threads.push_back(std::thread(serve, listenSocket, SplitMix::split(nSeed, i), std::ref(stats)));
+	}
+	for (auto thread = threads.begin(); thread != threads.end(); thread++) {
+		thread->join();
+	}
+	::close(listenSocket);
+	unlink(socketPath.c_str());
+	const double dTotalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << " Served " << stats.nMoves << " moves to " << stats.nSessions << " sessions in " << dTotalTime << " s";
+	std::cout << " (" << (dTotalTime > 0 ? stats.nMoves / dTotalTime : 0) << " moves/s)." << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,343 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "minefield.hpp"
+#include "solver.hpp"
+#include "probability.hpp"
+#include "generator.hpp"
+#include "replay.hpp"
+#include "splitmix.hpp"
+
+enum class MoveTypes {
+	REVEAL,
+	FLAG,
+	CHORD
+};
+
+struct ScriptedMove {
+	MoveTypes type;
+
+	int x;
+
+	int y;
+};
+
+void help(const char* name) {
+	std::cout << " Usage: " << name << " [options]" << std::endl;
+	std::cout << "  -d <level>  Use built-in difficulty level (0-8)" << std::endl;
+	std::cout << "  -c <cols>   Number of minefield columns" << std::endl;
+	std::cout << "  -r <rows>   Number of minefield rows" << std::endl;
+	std::cout << "  -m <mines>  Number of mines" << std::endl;
+	std::cout << "  -n <games>  Number of games to play (default 1000000)" << std::endl;
+	std::cout << "  -s <file>   Script of moves (reveal|flag|chord x y) played at the start of every game" << std::endl;
+	std::cout << "  -a          Reveal cells proven safe by the solver before guessing" << std::endl;
+	std::cout << "  -p          Guess the cell with the lowest mine probability (implies -a)" << std::endl;
+	std::cout << "  -g          Play boards which can be solved without guessing" << std::endl;
+	std::cout << "  -w <file>   Record the last game to a replay file" << std::endl;
+	std::cout << "  -l <file>   Play back a replay file (-n times) instead of playing games" << std::endl;
+	std::cout << "  -S <seed>   Seed of the mine layouts and guesses (random by default)" << std::endl;
+	std::cout << "  -v          Check that the recorded game (-w) plays back to the same minefield" << std::endl;
+}
+
+bool readScript(const std::string& fname, std::vector<ScriptedMove>& moves) {
+	std::ifstream ifile(fname.c_str());
+	if (!ifile.good())
+		return false;
+	std::string line;
+	while (std::getline(ifile, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+		std::stringstream stream(line);
+		std::string action;
+		ScriptedMove move;
+		if (!(stream >> action >> move.x >> move.y))
+			continue;
+		if (action == "reveal")
+			move.type = MoveTypes::REVEAL;
+		else if (action == "flag")
+			move.type = MoveTypes::FLAG;
+		else if (action == "chord")
+			move.type = MoveTypes::CHORD;
+		else {
+			std::cout << " Warning! Unknown scripted move (" << action << ")." << std::endl;
+			continue;
+		}
+		moves.push_back(move);
+	}
+	return true;
+}
+
+int playReplay(const std::string& fname, const unsigned long long& nGames) {
+	ReplayPlayer player;
+	if (!player.open(fname))
+		return 1;
+	Minefield field(player.getWidth(), player.getHeight(), player.getMines());
+	std::cout << " Replaying " << player.getEventCount() << " moves on a " << player.getWidth() << " x " << player.getHeight() << " minefield (";
+	std::cout << player.getMines() << " mines) " << nGames << " times." << std::endl;
+	unsigned long long nEvents = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned long long game = 0; game < nGames; game++) {
+		player.reset(field);
+		while (player.step(field)) {
+			nEvents++;
+		}
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	const char* states[] = { "NORMAL", "PAUSED", "WIN", "LOSS" };
+	std::cout << " Result:     " << states[(int)field.getState()] << std::endl;
+	std::cout << " Moves:      " << nEvents << std::endl;
+	std::cout << " Time:       " << elapsed.count() << " s" << std::endl;
+	std::cout << " Moves/sec:  " << (elapsed.count() > 0 ? nEvents / elapsed.count() : 0) << std::endl;
+	return 0;
+}
+
+// Play back a recorded game and compare it with the minefield it was recorded from
+bool verifyReplay(const std::string& fname, const Minefield& field) {
+	ReplayPlayer player;
+	if (!player.open(fname))
+		return false;
+	Minefield copy(player.getWidth(), player.getHeight(), player.getMines());
+	player.reset(copy);
+	while (player.step(copy)) {
+	}
+	std::vector<uint64_t> expected(field.getStateWords());
+	std::vector<uint64_t> played(copy.getStateWords());
+	field.saveState(expected.data());
+	copy.saveState(played.data());
+	return (copy.getState() == field.getState() && played == expected);
+}
+
+int main(int argc, char* argv[]) {
+	int nSizeX = 10;
+	int nSizeY = 10;
+	int nBombs = 10;
+	unsigned long long nGames = 1000000;
+	bool bUseSolver = false;
+	bool bUseProbabilities = false;
+	bool bNoGuess = false;
+	bool bVerifyReplay = false;
+	bool bSeeded = false;
+	uint64_t nSeed = 0;
+	std::vector<ScriptedMove> script;
+	std::string recordFile;
+	std::string replayFile;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg(argv[i]);
+		if (arg == "-h" || arg == "--help") {
+			help(argv[0]);
+			return 0;
+		}
+		if (arg == "-a") {
+			bUseSolver = true;
+			continue;
+		}
+		if (arg == "-g") {
+			bNoGuess = true;
+			continue;
+		}
+		if (arg == "-v") {
+			bVerifyReplay = true;
+			continue;
+		}
+		if (arg == "-p") {
+			bUseSolver = true;
+			bUseProbabilities = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cout << " Error! Missing argument to option " << arg << "." << std::endl;
+			return 1;
+		}
+		const char* value = argv[++i];
+		if (arg == "-d") {
+			if (!Minefield::getDifficulty((unsigned int)std::strtoul(value, 0, 10), nSizeX, nSizeY, nBombs)) {
+				std::cout << " Error! Invalid difficulty specified (" << value << ")." << std::endl;
+				return 1;
+			}
+		}
+		else if (arg == "-c")
+			nSizeX = std::atoi(value);
+		else if (arg == "-r")
+			nSizeY = std::atoi(value);
+		else if (arg == "-m")
+			nBombs = std::atoi(value);
+		else if (arg == "-n")
+			nGames = std::strtoull(value, 0, 10);
+		else if (arg == "-w")
+			recordFile = value;
+		else if (arg == "-l")
+			replayFile = value;
+		else if (arg == "-S") {
+			nSeed = std::strtoull(value, 0, 10);
+			bSeeded = true;
+		}
+		else if (arg == "-s") {
+			if (!readScript(value, script)) {
+				std::cout << " Error! Failed to read script file (" << value << ")." << std::endl;
+				return 1;
+			}
+		}
+		else {
+			std::cout << " Error! Unknown option " << arg << "." << std::endl;
+			help(argv[0]);
+			return 1;
+		}
+	}
+	if (!replayFile.empty()) // Headless playback
+		return playReplay(replayFile, nGames);
+	if (nSizeX <= 0 || nSizeY <= 0 || nBombs < 0 || nBombs >= nSizeX * nSizeY) {
+		std::cout << " Error! Invalid minefield (" << nSizeX << " x " << nSizeY << ", " << nBombs << " mines)." << std::endl;
+		return 1;
+	}
+
+	Minefield field(nSizeX, nSizeY, nBombs);
+	if (!bSeeded)
+		nSeed = SplitMix::randomSeed();
+	field.setSeed(SplitMix::split(nSeed, 0)); // Each generator uses its own stream of the seed, the same as the game
+
+	Solver solver;
+
+	ProbabilityEngine probabilities;
+
+	BoardGenerator generator;
+	generator.setSeed(SplitMix::split(nSeed, 1));
+	if (bNoGuess)
+		generator.prepare(nSizeX, nSizeY, nBombs);
+
+	// Record moves of the current game (only the last game is saved)
+	ReplayWriter recorder;
+	std::chrono::steady_clock::time_point gameStart;
+	auto record = [&](const ReplayEvents& type, const int& cell) {
+		if (recordFile.empty())
+			return;
+		if (!recorder.isRecording() && !field.isFirstCell()) // Mines are placed by the first uncovered cell
+			recorder.begin(field, cell);
+		recorder.addEvent(field, type, cell, std::chrono::duration<double>(std::chrono::steady_clock::now() - gameStart).count());
+	};
+
+	// Random number generator for unscripted moves
+	SplitMix rng(SplitMix::split(nSeed, 2));
+
+	std::cout << " Playing " << nGames << " games on a " << nSizeX << " x " << nSizeY << " minefield (" << nBombs << " mines, seed " << nSeed << ")." << std::endl;
+
+	const int nCells = field.getCells();
+	std::vector<int> candidates;
+	candidates.reserve(nCells);
+	unsigned long long nWins = 0;
+	unsigned long long nMoves = 0;
+	double dSolverTime = 0;
+	double dProbabilityTime = 0;
+	unsigned long long nGuesses = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned long long game = 0; game < nGames; game++) {
+		field.resetField();
+		recorder.clear();
+		gameStart = std::chrono::steady_clock::now();
+		if (bNoGuess) { // Start with a random first click on a board which is solvable from there
+			const int cell = rng.next(nCells);
+			std::vector<int> layout;
+			if (generator.getBoard(nSizeX, nSizeY, nBombs, cell, layout))
+				field.setMines(layout);
+			field.uncoverCell(cell);
+			record(ReplayEvents::REVEAL, cell);
+			nMoves++;
+		}
+		for (auto move = script.begin(); move != script.end() && field.getState() == GameStates::NORMAL; move++) {
+			if (move->x < 0 || move->x >= nSizeX || move->y < 0 || move->y >= nSizeY)
+				continue;
+			const int cell = move->y * nSizeX + move->x;
+			switch (move->type) {
+			case MoveTypes::REVEAL:
+				if (field.getCover(cell) == 1) {
+					field.uncoverCell(cell);
+					record(ReplayEvents::REVEAL, cell);
+				}
+				break;
+			case MoveTypes::FLAG:
+				if (field.getCover(cell) != 0) {
+					field.cycleFlag(cell);
+					record(ReplayEvents::FLAG, cell);
+				}
+				break;
+			case MoveTypes::CHORD:
+				if (field.chordCell(move->x, move->y))
+					record(ReplayEvents::CHORD, cell);
+				break;
+			default:
+				break;
+			}
+			nMoves++;
+		}
+		while (field.getState() == GameStates::NORMAL) { // Reveal random covered cells until the game ends
+			int cell = -1;
+			if (bUseSolver) {
+				auto solverStart = std::chrono::steady_clock::now();
+				solver.update(field);
+				field.clearChanges();
+				dSolverTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - solverStart).count();
+				if (!solver.getSafeCells().empty())
+					cell = solver.getSafeCells().get().front();
+			}
+			if (cell < 0 && bUseProbabilities && !field.isFirstCell()) { // Make the best guess
+				if (probabilities.compute(field, solver))
+					cell = probabilities.getSafestCell(field);
+				dProbabilityTime += probabilities.getTime();
+				nGuesses++;
+			}
+			if (cell < 0) { // Guess any covered cell (flagged or not) which is not a known mine
+				candidates.clear();
+				for (int i = 0; i < nCells; i++) {
+					if (field.getCover(i) != 0 && !(bUseSolver && solver.getState(i) == SolverStates::MINE))
+						candidates.push_back(i);
+				}
+				if (candidates.empty()) // Only proven mines are left covered
+					break;
+				cell = candidates[rng.next((int)candidates.size())];
+			}
+			while (field.getCover(cell) > 1) { // Clear the flag (or unknown mark) of a cell first
+				field.cycleFlag(cell);
+				record(ReplayEvents::FLAG, cell);
+				nMoves++;
+			}
+			field.uncoverCell(cell);
+			record(ReplayEvents::REVEAL, cell);
+			nMoves++;
+		}
+		if (field.getState() == GameStates::WIN)
+			nWins++;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	generator.stop();
+	if (!recordFile.empty() && recorder.save(recordFile)) {
+		std::cout << " Recorded last game to " << recordFile << std::endl;
+		if (bVerifyReplay) {
+			if (!verifyReplay(recordFile, field)) {
+				std::cout << " Error! Replay of the last game does not match the minefield." << std::endl;
+				return 1;
+			}
+			std::cout << " Replay of the last game matches the minefield." << std::endl;
+		}
+	}
+
+	std::cout << " Games:     " << nGames << std::endl;
+	std::cout << " Wins:      " << nWins << " (" << (nGames > 0 ? 100.0 * nWins / nGames : 0) << "%)" << std::endl;
+	std::cout << " Moves:     " << nMoves << std::endl;
+	std::cout << " Time:      " << elapsed.count() << " s" << std::endl;
+	std::cout << " Games/sec: " << (elapsed.count() > 0 ? nGames / elapsed.count() : 0) << std::endl;
+	if (bUseSolver)
+		std::cout << " Solver:    " << (nMoves > 0 ? 1E6 * dSolverTime / nMoves : 0) << " us/move" << std::endl;
+	if (bNoGuess) {
+		const double dGenerationTime = generator.getGenerationTime();
+		std::cout << " Boards:    " << generator.getBoardsGenerated() << " generated from " << generator.getAttempts() << " layouts (";
+		std::cout << (dGenerationTime > 0 ? generator.getBoardsGenerated() / dGenerationTime : 0) << " boards/sec/core, " << generator.getThreadCount() << " threads)" << std::endl;
+	}
+	if (bUseProbabilities)
+		std::cout << " Guesses:   " << nGuesses << " (" << (nGuesses > 0 ? 1E3 * dProbabilityTime / nGuesses : 0) << " ms/guess, " << probabilities.getThreadCount() << " threads)" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,440 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "minefield.hpp"
+#include "solver.hpp"
+#include "probability.hpp"
+#include "threadpool.hpp"
+#include "splitmix.hpp"
+
+// Strategy which chooses the next cell to reveal. Every worker thread plays with its own bot.
+class Bot {
+public:
+	virtual ~Bot() {}
+
+	virtual std::string getName() const = 0;
+
+	// Choose a covered cell to reveal (the first cell has already been revealed and the game is not over)
+	virtual int chooseCell(Minefield& field, SplitMix& random) = 0;
+
+protected:
+	// Choose a random covered cell which is not known to be a mine
+	static int guessCell(const Minefield& field, SplitMix& random, const Solver* solver = 0x0) {
+		while (true) {
+			const int cell = random.next(field.getCells());
+			if (field.getCover(cell) == 1 && (!solver || solver->getState(cell) != SolverStates::MINE))
+				return cell;
+		}
+	}
+};
+
+// Reveals random cells
+class RandomBot : public Bot {
+public:
+	std::string getName() const override {
+		return "random";
+	}
+
+	int chooseCell(Minefield& field, SplitMix& random) override {
+		return guessCell(field, random);
+	}
+};
+
+// Reveals cells proven safe by the solver, and guesses randomly when there are none
+class RuleBot : public Bot {
+public:
+	RuleBot() :
+		solver()
+	{
+	}
+
+	std::string getName() const override {
+		return "rule";
+	}
+
+	int chooseCell(Minefield& field, SplitMix& random) override {
+		solver.update(field);
+		field.clearChanges();
+		if (!solver.getSafeCells().empty())
+			return solver.getSafeCells().get().front();
+		return guessCell(field, random, &solver);
+	}
+
+protected:
+	Solver solver;
+};
+
+// Reveals cells proven safe by the solver, and guesses the cell with the lowest mine probability when there are none
+class ProbabilityBot : public RuleBot {
+public:
+	ProbabilityBot() :
+		RuleBot(),
+		probabilities(1) // Games are already spread over every core
+	{
+	}
+
+	std::string getName() const override {
+		return "probability";
+	}
+
+	int chooseCell(Minefield& field, SplitMix& random) override {
+		solver.update(field);
+		field.clearChanges();
+		if (!solver.getSafeCells().empty())
+			return solver.getSafeCells().get().front();
+		if (probabilities.compute(field, solver)) {
+			const int cell = probabilities.getSafestCell(field);
+			if (cell >= 0)
+				return cell;
+		}
+		return guessCell(field, random, &solver);
+	}
+
+private:
+	ProbabilityEngine probabilities;
+};
+
+std::unique_ptr<Bot> createBot(const std::string& name) {
+	if (name == "random")
+		return std::unique_ptr<Bot>(new RandomBot());
+	if (name == "rule")
+		return std::unique_ptr<Bot>(new RuleBot());
+	if (name == "probability")
+		return std::unique_ptr<Bot>(new ProbabilityBot());
+	return std::unique_ptr<Bot>();
+}
+
+// Running mean and variance (Welford's method), which can be merged with the statistics of another thread
+struct RunningStatistics {
+	unsigned long long nCount;
+
+	double dMean;
+
+	double dSumSquares; // Sum of squared differences from the mean
+
+	RunningStatistics() :
+		nCount(0),
+		dMean(0),
+		dSumSquares(0)
+	{
+	}
+
+	void add(const double& value) {
+		nCount++;
+		const double delta = value - dMean;
+		dMean += delta / nCount;
+		dSumSquares += delta * (value - dMean);
+	}
+
+	void merge(const RunningStatistics& other) {
+		if (other.nCount == 0)
+			return;
+		const unsigned long long nTotal = nCount + other.nCount;
+		const double delta = other.dMean - dMean;
+		dMean += delta * other.nCount / nTotal;
+		dSumSquares += other.dSumSquares + delta * delta * ((double)nCount * other.nCount / nTotal);
+		nCount = nTotal;
+	}
+
+	// Half width of the 95% confidence interval of the mean
+	double getError() const {
+		if (nCount < 2)
+			return 0;
+		return 1.96 * std::sqrt(dSumSquares / (nCount - 1) / nCount);
+	}
+};
+
+// Results of a block of games
+struct TournamentResult {
+	unsigned long long nGames;
+
+	unsigned long long nWins;
+
+	unsigned long long nMoves;
+
+	RunningStatistics boardValue; // 3BV of every board
+
+	RunningStatistics clearRate; // 3BV per second of won games
+
+	RunningStatistics gameTime; // Time per game (in milliseconds)
+
+	TournamentResult() :
+		nGames(0),
+		nWins(0),
+		nMoves(0),
+		boardValue(),
+		clearRate(),
+		gameTime()
+	{
+	}
+
+	void merge(const TournamentResult& other) {
+		nGames += other.nGames;
+		nWins += other.nWins;
+		nMoves += other.nMoves;
+		boardValue.merge(other.boardValue);
+		clearRate.merge(other.clearRate);
+		gameTime.merge(other.gameTime);
+	}
+};
+
+void help(const char* name) {
+	std::cout << " Usage: " << name << " [options]" << std::endl;
+	std::cout << "  -d <level>  Use built-in difficulty level (0-8), or \"all\" (default 8)" << std::endl;
+	std::cout << "  -c <cols>   Number of minefield columns" << std::endl;
+	std::cout << "  -r <rows>   Number of minefield rows" << std::endl;
+	std::cout << "  -m <mines>  Number of mines" << std::endl;
+	std::cout << "  -b <bots>   Comma separated list of bots (random, rule, probability), or \"all\" (default)" << std::endl;
+	std::cout << "  -n <games>  Number of games played by each bot (default 10000)" << std::endl;
+	std::cout << "  -t <count>  Number of threads (default one per hardware thread)" << std::endl;
+	std::cout << "  -s <seed>   Seed of the game streams (random by default)" << std::endl;
+}
+
+// Get the 3BV of a board, the number of clicks needed to clear it without flags. Each opening (a region of
+// cells with no neighboring mines, connected the same way a cascade spreads) takes one click, as does each
+// numbered cell which no cascade uncovers.
+int getBoardValue(const Minefield& field, std::vector<unsigned char>& marked, std::vector<int>& stack) {
+	const int nWidth = field.getWidth();
+	const TopologyGrid& grid = field.getTopologyGrid();
+	int neighbors[SquareTopology::nMaxFillNeighbors];
+	marked.assign(field.getCells(), 0);
+	int nValue = 0;
+	for (int i = 0; i < field.getCells(); i++) { // Openings
+		if (marked[i] || field.getTileType(i) != TileTypes::ZERO)
+			continue;
+		nValue++;
+		marked[i] = 1;
+		stack.push_back(i);
+		while (!stack.empty()) {
+			const int cell = stack.back();
+			stack.pop_back();
+			const int nNeighbors = SquareTopology::getFillNeighbors(grid, cell % nWidth, cell / nWidth, neighbors);
+			for (int j = 0; j < nNeighbors; j++) {
+				const int neighbor = neighbors[j];
+				if (marked[neighbor])
+					continue;
+				marked[neighbor] = 1;
+				if (field.getTileType(neighbor) == TileTypes::ZERO)
+					stack.push_back(neighbor);
+			}
+		}
+	}
+	for (int i = 0; i < field.getCells(); i++) { // Numbered cells outside of openings
+		if (!marked[i] && field.getTileType(i) != TileTypes::BOMB)
+			nValue++;
+	}
+	return nValue;
+}
+
+// Play games [first, last) with one bot. Game i is played on the same board by every bot.
+TournamentResult playGames(const std::string& botName, const int& nWidth, const int& nHeight, const int& nMines, const uint64_t& seed, const unsigned long long& first, const unsigned long long& last) {
+	TournamentResult result;
+	std::unique_ptr<Bot> bot = createBot(botName);
+	Minefield field(nWidth, nHeight, nMines);
+	std::vector<unsigned char> marked;
+	std::vector<int> stack;
+	for (unsigned long long game = first; game < last; game++) {
+		SplitMix boardRandom(SplitMix::split(seed, 2 * game));
+		SplitMix botRandom(SplitMix::split(seed, 2 * game + 1));
+		const auto gameStart = std::chrono::steady_clock::now();
+		field.setSeed(SplitMix::split(seed, 2 * game)); // Mines are placed from their own stream of the board seed
+		field.resetField();
+		const int firstCell = boardRandom.next(field.getCells());
+		field.placeBombs(firstCell);
+		const int nValue = getBoardValue(field, marked, stack);
+		field.uncoverCell(firstCell);
+		unsigned long long nMoves = 1;
+		while (field.getState() == GameStates::NORMAL) {
+			field.uncoverCell(bot->chooseCell(field, botRandom));
+			nMoves++;
+		}
+		const double dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - gameStart).count();
+		result.nGames++;
+		result.nMoves += nMoves;
+		result.boardValue.add(nValue);
+		result.gameTime.add(1E3 * dSeconds);
+		if (field.getState() == GameStates::WIN) {
+			result.nWins++;
+			if (dSeconds > 0)
+				result.clearRate.add(nValue / dSeconds);
+		}
+	}
+	return result;
+}
+
+// Wilson score interval of a win rate (95%)
+void getWinInterval(const unsigned long long& nWins, const unsigned long long& nGames, double& low, double& high) {
+	low = 0;
+	high = 0;
+	if (nGames == 0)
+		return;
+	const double z = 1.96;
+	const double p = (double)nWins / nGames;
+	const double denominator = 1 + z * z / nGames;
+	const double center = (p + z * z / (2 * nGames)) / denominator;
+	const double error = z * std::sqrt(p * (1 - p) / nGames + z * z / (4.0 * nGames * nGames)) / denominator;
+	low = std::max(0.0, center - error);
+	high = std::min(1.0, center + error);
+}
+
+int main(int argc, char* argv[]) {
+	int nSizeX = 0;
+	int nSizeY = 0;
+	int nBombs = 0;
+	std::vector<unsigned int> levels(1, 8);
+	std::vector<std::string> botNames;
+	unsigned long long nGames = 10000;
+	unsigned int nThreads = 0;
+	bool bSeeded = false;
+	uint64_t nSeed = 0;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg(argv[i]);
+		if (arg == "-h" || arg == "--help") {
+			help(argv[0]);
+			return 0;
+		}
+		if (i + 1 >= argc) {
+			std::cout << " Error! Missing argument to option " << arg << "." << std::endl;
+			return 1;
+		}
+		const std::string value = argv[++i];
+		if (arg == "-d") {
+			levels.clear();
+			for (unsigned int level = 0; level <= 8; level++) {
+				if (value == "all" || std::strtoul(value.c_str(), 0, 10) == level)
+					levels.push_back(level);
+			}
+			if (levels.empty()) {
+				std::cout << " Error! Invalid difficulty specified (" << value << ")." << std::endl;
+				return 1;
+			}
+		}
+		else if (arg == "-c")
+			nSizeX = std::atoi(value.c_str());
+		else if (arg == "-r")
+			nSizeY = std::atoi(value.c_str());
+		else if (arg == "-m")
+			nBombs = std::atoi(value.c_str());
+		else if (arg == "-n")
+			nGames = std::strtoull(value.c_str(), 0, 10);
+		else if (arg == "-t")
+			nThreads = (unsigned int)std::strtoul(value.c_str(), 0, 10);
+		else if (arg == "-s") {
+			nSeed = std::strtoull(value.c_str(), 0, 10);
+			bSeeded = true;
+		}
+		else if (arg == "-b") {
+			std::stringstream stream(value);
+			std::string name;
+			while (std::getline(stream, name, ',')) {
+				if (name != "all" && !createBot(name)) {
+					std::cout << " Error! Unknown bot (" << name << ")." << std::endl;
+					return 1;
+				}
+				botNames.push_back(name);
+			}
+		}
+		else {
+			std::cout << " Error! Unknown option " << arg << "." << std::endl;
+			help(argv[0]);
+			return 1;
+		}
+	}
+	if (botNames.empty() || std::find(botNames.begin(), botNames.end(), "all") != botNames.end()) {
+		botNames.clear();
+		botNames.push_back("random");
+		botNames.push_back("rule");
+		botNames.push_back("probability");
+	}
+
+	// Boards to play (a custom board replaces the difficulty levels)
+	struct TournamentBoard {
+		std::string name;
+
+		int nWidth;
+
+		int nHeight;
+
+		int nMines;
+	};
+	std::vector<TournamentBoard> boards;
+	if (nSizeX > 0 || nSizeY > 0 || nBombs > 0) {
+		if (nSizeX <= 0 || nSizeY <= 0 || nBombs < 0 || nBombs >= nSizeX * nSizeY) {
+			std::cout << " Error! Invalid minefield (" << nSizeX << " x " << nSizeY << ", " << nBombs << " mines)." << std::endl;
+			return 1;
+		}
+		TournamentBoard board = { "custom", nSizeX, nSizeY, nBombs };
+		boards.push_back(board);
+	}
+	else {
+		for (auto level = levels.begin(); level != levels.end(); level++) {
+			TournamentBoard board;
+			std::stringstream stream;
+			stream << "difficulty" << *level;
+			board.name = stream.str();
+			Minefield::getDifficulty(*level, board.nWidth, board.nHeight, board.nMines);
+			boards.push_back(board);
+		}
+	}
+
+	if (!bSeeded) // Print the seed, so that the tournament can be repeated
+		nSeed = SplitMix::randomSeed();
+
+	ThreadPool pool(nThreads);
+	std::cout << " Playing " << nGames << " games per bot on " << pool.getThreadCount() << " threads (seed " << nSeed << ")." << std::endl;
+	std::cout << std::endl;
+	std::cout << std::left << std::setw(14) << " Board" << std::setw(13) << "Bot" << std::right;
+	std::cout << std::setw(22) << "Win rate (95% CI)" << std::setw(10) << "3BV";
+	std::cout << std::setw(22) << "3BV/s (won)" << std::setw(22) << "ms/game" << std::setw(12) << "Games/s" << std::endl;
+	std::cout << std::fixed;
+	for (auto board = boards.begin(); board != boards.end(); board++) {
+		for (auto botName = botNames.begin(); botName != botNames.end(); botName++) {
+			// Split the games into blocks, each played by one task with its own board, bot, and results,
+			// so that threads share nothing until the results are merged at the end
+			const unsigned long long nBlocks = std::min(nGames, 8ULL * pool.getThreadCount());
+			std::vector<TournamentResult> results(nBlocks);
+			const auto startTime = std::chrono::steady_clock::now();
+			for (unsigned long long block = 0; block < nBlocks; block++) {
+				const unsigned long long first = block * nGames / nBlocks;
+				const unsigned long long last = (block + 1) * nGames / nBlocks;
+				TournamentResult* result = &results[block];
+				const std::string name = *botName;
+				const TournamentBoard layout = *board;
+				const uint64_t seed = nSeed;
+				pool.push([=]() {
+					*result = playGames(name, layout.nWidth, layout.nHeight, layout.nMines, seed, first, last);
+				});
+			}
+			pool.wait();
+			const double dElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			TournamentResult total;
+			for (auto result = results.begin(); result != results.end(); result++) {
+				total.merge(*result);
+			}
+			double dLow = 0;
+			double dHigh = 0;
+			getWinInterval(total.nWins, total.nGames, dLow, dHigh);
+			std::stringstream winRate;
+			winRate << std::fixed << std::setprecision(2) << (total.nGames > 0 ? 100.0 * total.nWins / total.nGames : 0) << "% [" << 100 * dLow << ", " << 100 * dHigh << "]";
+			std::stringstream clearRate;
+			clearRate << std::fixed << std::setprecision(1) << total.clearRate.dMean << " +/- " << total.clearRate.getError();
+			std::stringstream gameTime;
+			gameTime << std::fixed << std::setprecision(4) << total.gameTime.dMean << " +/- " << total.gameTime.getError();
+			std::cout << " " << std::left << std::setw(13) << board->name << std::setw(13) << *botName << std::right;
+			std::cout << std::setw(22) << winRate.str() << std::setw(10) << std::setprecision(1) << total.boardValue.dMean;
+			std::cout << std::setw(22) << clearRate.str() << std::setw(22) << gameTime.str();
+			std::cout << std::setw(12) << std::setprecision(0) << (dElapsed > 0 ? total.nGames / dElapsed : 0) << std::endl;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,512 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "probability.hpp"
+#include "minefield.hpp"
+#include "solver.hpp"
+
+namespace {
+
+// Arbitrary precision unsigned integer (just enough for exact binomial weighting)
+class BigUInt {
+public:
+	BigUInt(const uint64_t& value = 0) :
+		words()
+	{
+		if (value != 0)
+			words.push_back((uint32_t)value);
+		if ((value >> 32) != 0)
+			words.push_back((uint32_t)(value >> 32));
+	}
+
+	bool isZero() const {
+		return words.empty();
+	}
+
+	BigUInt& operator+=(const BigUInt& rhs) {
+		if (rhs.words.size() > words.size())
+			words.resize(rhs.words.size(), 0);
+		uint64_t carry = 0;
+		for (size_t i = 0; i < words.size(); i++) {
+			const uint64_t sum = (uint64_t)words[i] + (i < rhs.words.size() ? rhs.words[i] : 0) + carry;
+			words[i] = (uint32_t)sum;
+			carry = sum >> 32;
+			if (carry == 0 && i >= rhs.words.size())
+				break;
+		}
+		if (carry != 0)
+			words.push_back((uint32_t)carry);
+		return *this;
+	}
+
+	BigUInt& operator*=(const uint32_t& rhs) {
+		if (rhs == 0) {
+			words.clear();
+			return *this;
+		}
+		uint64_t carry = 0;
+		for (size_t i = 0; i < words.size(); i++) {
+			const uint64_t product = (uint64_t)words[i] * rhs + carry;
+			words[i] = (uint32_t)product;
+			carry = product >> 32;
+		}
+		if (carry != 0)
+			words.push_back((uint32_t)carry);
+		return *this;
+	}
+
+	BigUInt operator*(const BigUInt& rhs) const {
+		BigUInt product;
+		if (isZero() || rhs.isZero())
+			return product;
+		product.words.assign(words.size() + rhs.words.size(), 0);
+		for (size_t i = 0; i < words.size(); i++) {
+			uint64_t carry = 0;
+			for (size_t j = 0; j < rhs.words.size(); j++) {
+				const uint64_t sum = (uint64_t)words[i] * rhs.words[j] + product.words[i + j] + carry;
+				product.words[i + j] = (uint32_t)sum;
+				carry = sum >> 32;
+			}
+			product.words[i + rhs.words.size()] = (uint32_t)carry;
+		}
+		while (!product.words.empty() && product.words.back() == 0)
+			product.words.pop_back();
+		return product;
+	}
+
+	// Get the value as mantissa * 2^exponent
+	double toDouble(int& exponent) const {
+		double mantissa = 0;
+		const size_t first = (words.size() > 3 ? words.size() - 3 : 0); // Top 96 bits are plenty for a double
+		for (size_t i = words.size(); i > first; i--) {
+			mantissa = mantissa * 4294967296.0 + words[i - 1];
+		}
+		exponent = 32 * (int)first;
+		return mantissa;
+	}
+
+	// Get the ratio of two big numbers as a double
+	static double ratio(const BigUInt& numerator, const BigUInt& denominator) {
+		if (numerator.isZero() || denominator.isZero())
+			return 0;
+		int numeratorExponent;
+		int denominatorExponent;
+		const double numeratorMantissa = numerator.toDouble(numeratorExponent);
+		const double denominatorMantissa = denominator.toDouble(denominatorExponent);
+		return std::ldexp(numeratorMantissa / denominatorMantissa, numeratorExponent - denominatorExponent);
+	}
+
+private:
+	std::vector<uint32_t> words; // Least significant word first
+};
+
+typedef std::vector<BigUInt> Distribution; // Number of arrangements for each total number of mines
+
+Distribution convolve(const Distribution& lhs, const Distribution& rhs) {
+	if (lhs.empty() || rhs.empty())
+		return Distribution();
+	Distribution result(lhs.size() + rhs.size() - 1);
+	for (size_t i = 0; i < lhs.size(); i++) {
+		if (lhs[i].isZero())
+			continue;
+		for (size_t j = 0; j < rhs.size(); j++) {
+			if (!rhs[j].isZero())
+				result[i + j] += lhs[i] * rhs[j];
+		}
+	}
+	return result;
+}
+
+// Independent group of frontier cells and the constraints between them
+struct Component {
+	std::vector<int> cells; // Frontier cells (in enumeration order)
+
+	std::vector<int> targets; // Remaining mines of each constraint
+
+	std::vector<int> sizes; // Number of cells in each constraint
+
+	std::vector<std::vector<int> > cellConstraints; // Constraints containing each cell
+};
+
+struct TaskResult {
+	std::vector<uint64_t> solutions; // Number of arrangements with k mines
+
+	std::vector<uint64_t> cellCounts; // Number of arrangements with k mines where a cell is a mine [cell * (n + 1) + k]
+
+	std::chrono::steady_clock::time_point startTime;
+
+	std::chrono::steady_clock::time_point stopTime;
+};
+
+// Depth-first enumeration of the mine arrangements of one component
+class Enumerator {
+public:
+	Enumerator(const Component& comp, const int& maxMines, TaskResult& output) :
+		nCells((int)comp.cells.size()),
+		nMaxMines(maxMines),
+		nMines(0),
+		component(comp),
+		result(output),
+		sums(comp.targets.size(), 0),
+		left(comp.sizes),
+		values(comp.cells.size(), 0)
+	{
+	}
+
+	// Enumerate all arrangements where the first cells are set to the bits of a prefix
+	void run(const uint64_t& prefix, const int& nPrefixCells) {
+		result.solutions.assign(nCells + 1, 0);
+		result.cellCounts.assign((size_t)nCells * (nCells + 1), 0);
+		for (int i = 0; i < nPrefixCells; i++) {
+			const unsigned char value = (unsigned char)((prefix >> i) & 1);
+			if (!assign(i, value))
+				return;
+		}
+		recurse(nPrefixCells);
+	}
+
+private:
+	int nCells;
+
+	int nMaxMines;
+
+	int nMines;
+
+	const Component& component;
+
+	TaskResult& result;
+
+	std::vector<int> sums;
+
+	std::vector<int> left;
+
+	std::vector<unsigned char> values;
+
+	bool assign(const int& cell, const unsigned char& value) {
+		if (nMines + value > nMaxMines)
+			return false;
+		const std::vector<int>& constraints = component.cellConstraints[cell];
+		bool valid = true;
+		for (auto c = constraints.begin(); c != constraints.end(); c++) {
+			sums[*c] += value;
+			left[*c]--;
+			if (sums[*c] > component.targets[*c] || sums[*c] + left[*c] < component.targets[*c])
+				valid = false;
+		}
+		if (!valid) {
+			unassign(cell, value);
+			return false;
+		}
+		values[cell] = value;
+		nMines += value;
+		return true;
+	}
+
+	void unassign(const int& cell, const unsigned char& value) {
+		const std::vector<int>& constraints = component.cellConstraints[cell];
+		for (auto c = constraints.begin(); c != constraints.end(); c++) {
+			sums[*c] -= value;
+			left[*c]++;
+		}
+	}
+
+	void recurse(const int& cell) {
+		if (cell == nCells) { // Found a consistent arrangement
+			result.solutions[nMines]++;
+			for (int i = 0; i < nCells; i++) {
+				if (values[i])
+					result.cellCounts[(size_t)i * (nCells + 1) + nMines]++;
+			}
+			return;
+		}
+		for (unsigned char value = 0; value <= 1; value++) {
+			if (!assign(cell, value))
+				continue;
+			recurse(cell + 1);
+			nMines -= value;
+			unassign(cell, value);
+		}
+	}
+};
+
+// Number of prefix cells used to split a component into parallel tasks
+int getSplitCells(const int& nCells, const size_t& nThreads) {
+	int nSplit = 0;
+	while ((1ULL << nSplit) < 4 * nThreads) // Around four tasks per thread
+		nSplit++;
+	return std::max(0, std::min(nSplit, nCells - 12)); // Small components are not worth splitting
+}
+
+int findRoot(std::vector<int>& parents, int index) {
+	while (parents[index] != index) {
+		parents[index] = parents[parents[index]];
+		index = parents[index];
+	}
+	return index;
+}
+
+} // namespace
+
+ProbabilityEngine::ProbabilityEngine(const unsigned int& nThreads/*=0*/) :
+	dOtherProbability(0),
+	dTime(0),
+	pool(nThreads),
+	probabilities(),
+	components()
+{
+}
+
+bool ProbabilityEngine::compute(const Minefield& field, const Solver& solver) {
+	auto startTime = std::chrono::steady_clock::now();
+	const int nCells = field.getCells();
+	probabilities.assign(nCells, -1);
+	components.clear();
+
+	// Cells proven by the solver
+	for (int i = 0; i < nCells; i++) {
+		switch (solver.getState(i)) {
+		case SolverStates::HIDDEN:
+			probabilities[i] = 0;
+			break;
+		case SolverStates::SAFE:
+			probabilities[i] = 0;
+			break;
+		case SolverStates::MINE:
+			probabilities[i] = 1;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Frontier cells, and the constraints touching them
+	const std::vector<int>& frontier = solver.getFrontier().get();
+	const int nFrontier = (int)frontier.size();
+	std::vector<int> localIndex(nCells, -1);
+	for (int i = 0; i < nFrontier; i++) {
+		localIndex[frontier[i]] = i;
+	}
+	std::vector<int> constraintCells;
+	std::vector<int> constraintIndex(nCells, -1);
+	std::vector<int> parents(nFrontier);
+	for (int i = 0; i < nFrontier; i++) {
+		parents[i] = i;
+	}
+	int neighbors[nMaxTopologyNeighbors];
+	for (int i = 0; i < nFrontier; i++) {
+		const int nNeighbors = solver.getNeighbors(frontier[i], neighbors);
+		for (int j = 0; j < nNeighbors; j++) {
+			const int cell = neighbors[j];
+			if (solver.getState(cell) != SolverStates::REVEALED || constraintIndex[cell] >= 0)
+				continue;
+			constraintIndex[cell] = (int)constraintCells.size();
+			constraintCells.push_back(cell);
+		}
+	}
+
+	// Join frontier cells sharing a constraint into components
+	std::vector<std::vector<int> > constraintMembers(constraintCells.size());
+	for (size_t c = 0; c < constraintCells.size(); c++) {
+		const int nNeighbors = solver.getNeighbors(constraintCells[c], neighbors);
+		for (int j = 0; j < nNeighbors; j++) {
+			if (localIndex[neighbors[j]] >= 0)
+				constraintMembers[c].push_back(localIndex[neighbors[j]]);
+		}
+		for (size_t j = 1; j < constraintMembers[c].size(); j++) {
+			parents[findRoot(parents, constraintMembers[c][j])] = findRoot(parents, constraintMembers[c][0]);
+		}
+	}
+	std::vector<std::vector<int> > frontierConstraints(nFrontier);
+	for (size_t c = 0; c < constraintCells.size(); c++) {
+		for (auto member = constraintMembers[c].begin(); member != constraintMembers[c].end(); member++) {
+			frontierConstraints[*member].push_back((int)c);
+		}
+	}
+
+	// Build components, ordering cells breadth first so constraints are closed early during enumeration
+	std::vector<Component> comps;
+	std::vector<int> componentIndex(nFrontier, -1);
+	std::vector<int> cellPosition(nFrontier, -1);
+	std::vector<int> localConstraint(constraintCells.size(), -1);
+	for (int i = 0; i < nFrontier; i++) {
+		if (componentIndex[i] >= 0)
+			continue;
+		const int root = findRoot(parents, i);
+		comps.push_back(Component());
+		Component& comp = comps.back();
+		std::vector<int> order(1, i);
+		componentIndex[i] = (int)comps.size() - 1;
+		for (size_t j = 0; j < order.size(); j++) {
+			const std::vector<int>& cellConstraints = frontierConstraints[order[j]];
+			for (auto c = cellConstraints.begin(); c != cellConstraints.end(); c++) {
+				for (auto member = constraintMembers[*c].begin(); member != constraintMembers[*c].end(); member++) {
+					if (componentIndex[*member] >= 0 || findRoot(parents, *member) != root)
+						continue;
+					componentIndex[*member] = componentIndex[i];
+					order.push_back(*member);
+				}
+			}
+		}
+		comp.cellConstraints.resize(order.size());
+		for (size_t j = 0; j < order.size(); j++) {
+			cellPosition[order[j]] = (int)j;
+			comp.cells.push_back(frontier[order[j]]);
+		}
+		for (size_t j = 0; j < order.size(); j++) {
+			const std::vector<int>& cellConstraints = frontierConstraints[order[j]];
+			for (auto c = cellConstraints.begin(); c != cellConstraints.end(); c++) {
+				if (localConstraint[*c] < 0) {
+					localConstraint[*c] = (int)comp.targets.size();
+					comp.targets.push_back(solver.getRemainingMines(constraintCells[*c]));
+					comp.sizes.push_back((int)constraintMembers[*c].size());
+				}
+				comp.cellConstraints[j].push_back(localConstraint[*c]);
+			}
+		}
+	}
+
+	// Number of mines which are not proven, and covered cells away from the frontier
+	const int nRemainingMines = field.getBombs() - (int)solver.getMineCells().size();
+	const int nOtherCells = nCells - solver.getRevealedCells() - (int)solver.getSafeCells().size() - (int)solver.getMineCells().size() - nFrontier;
+
+	// Enumerate every component, splitting large components into tasks with fixed leading cells
+	std::vector<std::vector<TaskResult> > results(comps.size());
+	for (size_t c = 0; c < comps.size(); c++) {
+		const int nSplit = getSplitCells((int)comps[c].cells.size(), pool.getThreadCount());
+		results[c].resize((size_t)1 << nSplit);
+		for (size_t t = 0; t < results[c].size(); t++) {
+			const Component* comp = &comps[c];
+			TaskResult* output = &results[c][t];
+			pool.push([comp, output, t, nSplit, nRemainingMines]() {
+				output->startTime = std::chrono::steady_clock::now();
+				Enumerator enumerator(*comp, nRemainingMines, *output);
+				enumerator.run(t, nSplit);
+				output->stopTime = std::chrono::steady_clock::now();
+			});
+		}
+	}
+	pool.wait();
+
+	// Sum the results of each component's tasks
+	std::vector<Distribution> distributions(comps.size());
+	std::vector<std::vector<uint64_t> > cellCounts(comps.size());
+	for (size_t c = 0; c < comps.size(); c++) {
+		const size_t n = comps[c].cells.size();
+		std::vector<uint64_t> solutions(n + 1, 0);
+		cellCounts[c].assign(n * (n + 1), 0);
+		ComponentInfo info;
+		info.nCells = (int)n;
+		info.nConstraints = (int)comps[c].targets.size();
+		info.nTasks = (int)results[c].size();
+		info.nSolutions = 0;
+		info.dCpuTime = 0;
+		auto firstStart = results[c].front().startTime;
+		auto lastStop = results[c].front().stopTime;
+		for (auto task = results[c].begin(); task != results[c].end(); task++) {
+			for (size_t k = 0; k <= n; k++) {
+				solutions[k] += task->solutions[k];
+			}
+			for (size_t i = 0; i < cellCounts[c].size(); i++) {
+				cellCounts[c][i] += task->cellCounts[i];
+			}
+			info.dCpuTime += std::chrono::duration<double>(task->stopTime - task->startTime).count();
+			firstStart = std::min(firstStart, task->startTime);
+			lastStop = std::max(lastStop, task->stopTime);
+		}
+		info.dWallTime = std::chrono::duration<double>(lastStop - firstStart).count();
+		distributions[c].resize(n + 1);
+		for (size_t k = 0; k <= n; k++) {
+			distributions[c][k] = BigUInt(solutions[k]);
+			info.nSolutions += solutions[k];
+		}
+		components.push_back(info);
+	}
+
+	// Weight of every total number of frontier mines K: the number of ways to place the remaining
+	// M - K mines in the U other cells, C(U, M - K). All weights are scaled by the same factor
+	// (M! / j0!) / C(U, j0), where j0 = M - Kmax, so that they are small integer products.
+	const int nMaxFrontierMines = nFrontier;
+	const int j0 = std::max(0, nRemainingMines - nMaxFrontierMines);
+	std::vector<BigUInt> weights(nMaxFrontierMines + 1);
+	for (int K = 0; K <= nMaxFrontierMines; K++) {
+		const int j = nRemainingMines - K;
+		if (j < 0 || j > nOtherCells || j0 > nOtherCells)
+			continue;
+		BigUInt weight(1);
+		for (int t = j0 + 1; t <= j; t++) {
+			weight *= (uint32_t)(nOtherCells - t + 1);
+		}
+		for (int t = j + 1; t <= nRemainingMines; t++) {
+			weight *= (uint32_t)t;
+		}
+		weights[K] = weight;
+	}
+
+	// Distribution of the total number of frontier mines, with and without each component
+	std::vector<Distribution> prefix(comps.size() + 1, Distribution(1, BigUInt(1)));
+	std::vector<Distribution> suffix(comps.size() + 1, Distribution(1, BigUInt(1)));
+	for (size_t c = 0; c < comps.size(); c++) {
+		prefix[c + 1] = convolve(prefix[c], distributions[c]);
+	}
+	for (size_t c = comps.size(); c > 0; c--) {
+		suffix[c - 1] = convolve(suffix[c], distributions[c - 1]);
+	}
+	const Distribution& total = prefix[comps.size()];
+	BigUInt totalWeight;
+	BigUInt otherWeight;
+	for (size_t K = 0; K < total.size() && K < weights.size(); K++) {
+		if (total[K].isZero() || weights[K].isZero())
+			continue;
+		const BigUInt weighted = total[K] * weights[K];
+		totalWeight += weighted;
+		otherWeight += weighted * BigUInt((uint64_t)(nRemainingMines - (int)K)); // Mines left for the other cells
+	}
+	if (totalWeight.isZero()) { // No arrangement is consistent with the board
+		dTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		return false;
+	}
+	dOtherProbability = (nOtherCells > 0 ? BigUInt::ratio(otherWeight, totalWeight) / nOtherCells : 0);
+
+	// Combine each component with the arrangements of all other components
+	for (size_t c = 0; c < comps.size(); c++) {
+		const Distribution others = convolve(prefix[c], suffix[c + 1]);
+		const size_t n = comps[c].cells.size();
+		std::vector<BigUInt> expected(n + 1); // Weight of every arrangement of the other components, given k mines in this one
+		for (size_t k = 0; k <= n; k++) {
+			for (size_t K = 0; K < others.size() && k + K < weights.size(); K++) {
+				if (!others[K].isZero() && !weights[k + K].isZero())
+					expected[k] += others[K] * weights[k + K];
+			}
+		}
+		for (size_t i = 0; i < n; i++) {
+			BigUInt mineWeight;
+			for (size_t k = 0; k <= n; k++) {
+				const uint64_t count = cellCounts[c][i * (n + 1) + k];
+				if (count != 0)
+					mineWeight += expected[k] * BigUInt(count);
+			}
+			probabilities[comps[c].cells[i]] = BigUInt::ratio(mineWeight, totalWeight);
+		}
+	}
+
+	// Covered cells away from the frontier
+	for (int i = 0; i < nCells; i++) {
+		if (solver.getState(i) == SolverStates::HIDDEN && localIndex[i] < 0)
+			probabilities[i] = dOtherProbability;
+	}
+
+	dTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return true;
+}
+
+int ProbabilityEngine::getSafestCell(const Minefield& field) const {
+	int safest = -1;
+	for (int i = 0; i < (int)probabilities.size(); i++) {
+		if (probabilities[i] < 0 || field.getCover(i) == 0 || field.getCover(i) == 2)
+			continue;
+		if (safest < 0 || probabilities[i] < probabilities[safest])
+			safest = i;
+	}
+	return safest;
+}
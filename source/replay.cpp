@@ -0,0 +1,480 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#include "replay.hpp"
+#include "minefield.hpp"
+
+namespace {
+
+const char headerMagic[4] = { 'O', 'T', 'R', 'P' };
+
+const char indexMagic[4] = { 'O', 'T', 'R', 'X' };
+
+const uint64_t replayVersion = 1;
+
+const uint64_t keyframeRecord = 3; // Record type of a keyframe (move types are 0-2)
+
+void writeVarint(std::vector<uint8_t>& buffer, uint64_t value) {
+	while (value >= 0x80) {
+		buffer.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back((uint8_t)value);
+}
+
+void writeWord(std::vector<uint8_t>& buffer, const uint64_t& value) {
+	for (int i = 0; i < 8; i++) { // Little endian
+		buffer.push_back((uint8_t)(value >> (8 * i)));
+	}
+}
+
+bool readVarint(const uint8_t* data, const size_t& size, size_t& offset, uint64_t& value) {
+	value = 0;
+	for (int shift = 0; shift < 64 && offset < size; shift += 7) {
+		const uint8_t byte = data[offset++];
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+uint64_t readWord(const uint8_t* data) {
+	uint64_t value = 0;
+	for (int i = 0; i < 8; i++) {
+		value |= (uint64_t)data[i] << (8 * i);
+	}
+	return value;
+}
+
+// Map signed cell deltas to unsigned varints (0, -1, 1, -2, ...)
+uint64_t zigzag(const int64_t& value) {
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t unzigzag(const uint64_t& value) {
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+} // namespace
+
+ReplayWriter::ReplayWriter() :
+	bRecording(false),
+	nEvents(0),
+	nKeyframeInterval(256),
+	nPreviousCell(0),
+	nPreviousTime(0),
+	buffer(),
+	keyframes(),
+	stateWords(),
+	heldEvents()
+{
+}
+
+void ReplayWriter::begin(const Minefield& field, const int& safeCell) {
+	std::vector<HeldEvent> held;
+	held.swap(heldEvents);
+	clear();
+	bRecording = true;
+	buffer.reserve(65536); // Kept between games, so that recording rarely allocates
+	keyframes.reserve(buffer.capacity() / (2 * nKeyframeInterval) + 1); // Every move takes at least two bytes
+	stateWords.resize(field.getStateWords());
+
+	// Header
+	buffer.insert(buffer.end(), headerMagic, headerMagic + 4);
+	writeVarint(buffer, replayVersion);
+	writeVarint(buffer, field.getWidth());
+	writeVarint(buffer, field.getHeight());
+	writeVarint(buffer, safeCell);
+	writeVarint(buffer, nKeyframeInterval);
+
+	// Mine layout (distance from the previous mine)
+	const BitPlane& mines = field.getMinePlane();
+	writeVarint(buffer, mines.count());
+	int previous = 0;
+	for (int y = 0; y < field.getHeight(); y++) { // Over all rows
+		const uint64_t* row = mines.getRow(y);
+		for (int w = 0; w < mines.getRowWords(); w++) {
+			for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+				const int cell = y * field.getWidth() + 64 * w + BitPlane::lowestBit(bits);
+				writeVarint(buffer, cell - previous);
+				previous = cell;
+			}
+		}
+	}
+	nPreviousCell = safeCell;
+
+	// Moves made before the mines were placed (the board has changed since, so no keyframes are written)
+	for (auto event = held.begin(); event != held.end(); event++) {
+		writeEvent(event->type, event->cell, event->time);
+	}
+	held.clear();
+	heldEvents.swap(held); // Keep the capacity for the next game
+}
+
+void ReplayWriter::addEvent(const Minefield& field, const ReplayEvents& type, const int& cell, const double& time) {
+	if (!bRecording) { // Mines not placed yet
+		HeldEvent event;
+		event.type = type;
+		event.cell = cell;
+		event.time = time;
+		heldEvents.push_back(event);
+		return;
+	}
+	writeEvent(type, cell, time);
+
+	// Cover state of every cell, so that players do not need to replay the whole game to seek
+	if (nEvents % nKeyframeInterval == 0 && field.getState() == GameStates::NORMAL) {
+		keyframes.push_back(buffer.size());
+		writeVarint(buffer, keyframeRecord);
+		writeVarint(buffer, nEvents);
+		writeVarint(buffer, nPreviousCell);
+		writeVarint(buffer, nPreviousTime);
+		stateWords.resize(field.getStateWords());
+		field.saveState(stateWords.data());
+		writeVarint(buffer, stateWords.size());
+		for (auto word = stateWords.begin(); word != stateWords.end(); word++) {
+			writeWord(buffer, *word);
+		}
+	}
+}
+
+bool ReplayWriter::save(const std::string& fname) {
+	if (!bRecording)
+		return false;
+
+	// Keyframe index
+	const uint64_t indexOffset = buffer.size();
+	writeWord(buffer, nEvents);
+	writeWord(buffer, keyframes.size());
+	for (auto offset = keyframes.begin(); offset != keyframes.end(); offset++) {
+		writeWord(buffer, *offset);
+	}
+	writeWord(buffer, indexOffset);
+	buffer.insert(buffer.end(), indexMagic, indexMagic + 4);
+
+	std::ofstream ofile(fname.c_str(), std::ios::binary);
+	if (ofile.good())
+		ofile.write((const char*)buffer.data(), buffer.size());
+	const bool bSuccess = ofile.good();
+	if (!bSuccess)
+		std::cout << " Error! Failed to write replay file (" << fname << ")." << std::endl;
+	clear();
+	return bSuccess;
+}
+
+void ReplayWriter::clear() {
+	bRecording = false;
+	nEvents = 0;
+	nPreviousCell = 0;
+	nPreviousTime = 0;
+	buffer.clear();
+	keyframes.clear();
+	heldEvents.clear();
+}
+
+void ReplayWriter::writeEvent(const ReplayEvents& type, const int& cell, const double& time) {
+	const uint64_t timeMilliseconds = std::max(nPreviousTime, (uint64_t)std::llround(std::max(0.0, time) * 1E3));
+	writeVarint(buffer, (zigzag(cell - nPreviousCell) << 2) | (uint64_t)type);
+	writeVarint(buffer, timeMilliseconds - nPreviousTime);
+	nPreviousCell = cell;
+	nPreviousTime = timeMilliseconds;
+	nEvents++;
+}
+
+ReplayPlayer::ReplayPlayer() :
+	data(0x0),
+	nSize(0),
+	nRecordsBegin(0),
+	nRecordsEnd(0),
+	nOffset(0),
+	nEvents(0),
+	nPosition(0),
+	nWidth(0),
+	nHeight(0),
+	nSafeCell(0),
+	nPreviousCell(0),
+	nPreviousTime(0),
+	layout(),
+	keyframes(),
+	fileData()
+{
+}
+
+ReplayPlayer::~ReplayPlayer() {
+	close();
+}
+
+double ReplayPlayer::getNextEventTime() const {
+	size_t offset = nOffset;
+	ReplayEvents type;
+	int cell = nPreviousCell;
+	uint64_t time = nPreviousTime;
+	if (!readEvent(offset, type, cell, time))
+		return nPreviousTime / 1E3;
+	return time / 1E3;
+}
+
+bool ReplayPlayer::open(const std::string& fname) {
+	close();
+#ifndef _WIN32
+	const int fd = ::open(fname.c_str(), O_RDONLY);
+	if (fd >= 0) {
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			void* mapped = mmap(0x0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped != MAP_FAILED) {
+				data = (const uint8_t*)mapped;
+				nSize = (size_t)info.st_size;
+			}
+		}
+		::close(fd);
+	}
+#else
+	std::ifstream ifile(fname.c_str(), std::ios::binary);
+	if (ifile.good()) {
+		fileData.assign(std::istreambuf_iterator<char>(ifile), std::istreambuf_iterator<char>());
+		if (!fileData.empty()) {
+			data = fileData.data();
+			nSize = fileData.size();
+		}
+	}
+#endif
+	if (!data) {
+		std::cout << " Error! Failed to open replay file (" << fname << ")." << std::endl;
+		return false;
+	}
+
+	// Header
+	size_t offset = 4;
+	uint64_t version = 0;
+	uint64_t width = 0;
+	uint64_t height = 0;
+	uint64_t safeCell = 0;
+	uint64_t interval = 0;
+	uint64_t nMines = 0;
+	if (nSize < 4 || std::memcmp(data, headerMagic, 4) != 0 || !readVarint(data, nSize, offset, version) || version != replayVersion ||
+	    !readVarint(data, nSize, offset, width) || !readVarint(data, nSize, offset, height) || !readVarint(data, nSize, offset, safeCell) ||
+	    !readVarint(data, nSize, offset, interval) || !readVarint(data, nSize, offset, nMines) || width * height == 0 || nMines >= width * height) {
+		std::cout << " Error! Invalid replay file (" << fname << ")." << std::endl;
+		close();
+		return false;
+	}
+	nWidth = (int)width;
+	nHeight = (int)height;
+	nSafeCell = (int)safeCell;
+	uint64_t cell = 0;
+	for (uint64_t i = 0; i < nMines; i++) {
+		uint64_t delta;
+		if (!readVarint(data, nSize, offset, delta) || cell + delta >= width * height) {
+			std::cout << " Error! Invalid mine layout in replay file (" << fname << ")." << std::endl;
+			close();
+			return false;
+		}
+		cell += delta;
+		layout.push_back((int)cell);
+	}
+	nRecordsBegin = offset;
+	nRecordsEnd = nSize;
+
+	// Keyframe index
+	bool bIndexed = false;
+	if (nSize >= nRecordsBegin + 28 && std::memcmp(data + nSize - 4, indexMagic, 4) == 0) {
+		const uint64_t indexOffset = readWord(data + nSize - 12);
+		if (indexOffset >= nRecordsBegin && indexOffset + 16 <= nSize - 12) {
+			const uint64_t nKeyframes = readWord(data + indexOffset + 8);
+			if (indexOffset + 16 + 8 * nKeyframes == nSize - 12) {
+				bIndexed = true;
+				nEvents = (size_t)readWord(data + indexOffset);
+				nRecordsEnd = (size_t)indexOffset;
+				for (uint64_t i = 0; i < nKeyframes && bIndexed; i++) {
+					size_t keyframeOffset = (size_t)readWord(data + indexOffset + 16 + 8 * i);
+					Keyframe keyframe;
+					bIndexed = readKeyframe(keyframeOffset, keyframe, 0x0);
+					keyframes.push_back(keyframe);
+				}
+			}
+		}
+	}
+	if (!bIndexed && !buildIndex()) { // Unfinished log, find the keyframes by reading every record
+		std::cout << " Error! Corrupt replay file (" << fname << ")." << std::endl;
+		close();
+		return false;
+	}
+
+	nOffset = nRecordsBegin;
+	nPreviousCell = nSafeCell;
+	return true;
+}
+
+void ReplayPlayer::close() {
+#ifndef _WIN32
+	if (data && fileData.empty())
+		munmap((void*)data, nSize);
+#endif
+	data = 0x0;
+	nSize = 0;
+	nRecordsBegin = 0;
+	nRecordsEnd = 0;
+	nOffset = 0;
+	nEvents = 0;
+	nPosition = 0;
+	nPreviousCell = 0;
+	nPreviousTime = 0;
+	layout.clear();
+	keyframes.clear();
+	fileData.clear();
+}
+
+bool ReplayPlayer::reset(Minefield& field) {
+	if (!data)
+		return false;
+	if (field.getWidth() != nWidth || field.getHeight() != nHeight || field.getBombs() != getMines())
+		field.setSize(nWidth, nHeight, getMines());
+	field.resetField();
+	field.setMines(layout);
+	nOffset = nRecordsBegin;
+	nPosition = 0;
+	nPreviousCell = nSafeCell;
+	nPreviousTime = 0;
+	return true;
+}
+
+bool ReplayPlayer::step(Minefield& field) {
+	ReplayEvents type;
+	int cell = nPreviousCell;
+	uint64_t time = nPreviousTime;
+	if (!readEvent(nOffset, type, cell, time))
+		return false;
+	nPreviousCell = cell;
+	nPreviousTime = time;
+	nPosition++;
+	switch (type) {
+	case ReplayEvents::REVEAL:
+		if (field.getCover(cell) != 0 && field.getCover(cell) != 2) // Cell hidden (but not flagged)
+			field.uncoverCell(cell);
+		break;
+	case ReplayEvents::FLAG:
+		field.cycleFlag(cell);
+		break;
+	case ReplayEvents::CHORD:
+		field.chordCell(cell % nWidth, cell / nWidth);
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+bool ReplayPlayer::seek(Minefield& field, const size_t& position) {
+	if (!reset(field))
+		return false;
+	const size_t target = std::min(position, nEvents);
+
+	// Start from the last keyframe before the requested move
+	auto keyframe = std::upper_bound(keyframes.begin(), keyframes.end(), target, [](const size_t& value, const Keyframe& frame) {
+		return (value < frame.nEvent);
+	});
+	if (keyframe != keyframes.begin()) {
+		keyframe--;
+		size_t offset = keyframe->nOffset;
+		Keyframe frame;
+		std::vector<uint64_t> words;
+		if (readKeyframe(offset, frame, &words) && words.size() == field.getStateWords() && field.loadState(words.data())) {
+			nOffset = offset;
+			nPosition = frame.nEvent;
+			nPreviousCell = frame.nCell;
+			nPreviousTime = frame.nTime;
+		}
+	}
+	while (nPosition < target && step(field)) {
+	}
+	return (nPosition == target);
+}
+
+bool ReplayPlayer::readEvent(size_t& offset, ReplayEvents& type, int& cell, uint64_t& time) const {
+	while (offset < nRecordsEnd) {
+		size_t next = offset;
+		uint64_t value;
+		if (!readVarint(data, nRecordsEnd, next, value))
+			return false;
+		if ((value & 3) == keyframeRecord) { // Skip keyframes
+			Keyframe keyframe;
+			if (!readKeyframe(offset, keyframe, 0x0))
+				return false;
+			continue;
+		}
+		uint64_t delta;
+		if (!readVarint(data, nRecordsEnd, next, delta))
+			return false;
+		const int64_t newCell = cell + unzigzag(value >> 2);
+		if (newCell < 0 || newCell >= (int64_t)nWidth * nHeight)
+			return false;
+		type = (ReplayEvents)(value & 3);
+		cell = (int)newCell;
+		time += delta;
+		offset = next;
+		return true;
+	}
+	return false;
+}
+
+bool ReplayPlayer::readKeyframe(size_t& offset, Keyframe& keyframe, std::vector<uint64_t>* words) const {
+	keyframe.nOffset = offset;
+	uint64_t type;
+	uint64_t event;
+	uint64_t cell;
+	uint64_t nWords;
+	if (!readVarint(data, nRecordsEnd, offset, type) || type != keyframeRecord || !readVarint(data, nRecordsEnd, offset, event) ||
+	    !readVarint(data, nRecordsEnd, offset, cell) || !readVarint(data, nRecordsEnd, offset, keyframe.nTime) ||
+	    !readVarint(data, nRecordsEnd, offset, nWords) || offset + 8 * nWords > nRecordsEnd) {
+		return false;
+	}
+	keyframe.nEvent = (size_t)event;
+	keyframe.nCell = (int)cell;
+	if (words) {
+		words->resize((size_t)nWords);
+		for (size_t i = 0; i < words->size(); i++) {
+			(*words)[i] = readWord(data + offset + 8 * i);
+		}
+	}
+	offset += (size_t)(8 * nWords);
+	return true;
+}
+
+bool ReplayPlayer::buildIndex() {
+	size_t offset = nRecordsBegin;
+	nEvents = 0;
+	keyframes.clear();
+	ReplayEvents type;
+	int cell = nSafeCell;
+	uint64_t time = 0;
+	while (offset < nRecordsEnd) {
+		size_t next = offset;
+		uint64_t value;
+		if (!readVarint(data, nRecordsEnd, next, value))
+			break;
+		if ((value & 3) == keyframeRecord) {
+			Keyframe keyframe;
+			if (!readKeyframe(offset, keyframe, 0x0))
+				break;
+			keyframes.push_back(keyframe);
+			continue;
+		}
+		if (!readEvent(offset, type, cell, time))
+			break;
+		nEvents++;
+	}
+	nRecordsEnd = offset; // Ignore a partially written record at the end
+	return true;
+}
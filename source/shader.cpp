@@ -0,0 +1,47 @@
+#include <GL/glew.h>
+
+#include <iostream>
+
+#include "shader.hpp"
+
+unsigned int compileShader(const GLenum& type, const char* source, const char* name) {
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, 0);
+	glCompileShader(shader);
+	GLint status = 0;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE) {
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), 0, log);
+		std::cout << " Error! Failed to compile " << name << " shader: " << log << std::endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource, const char* name) {
+	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, name);
+	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, name);
+	if (vertexShader == 0 || fragmentShader == 0) {
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return 0;
+	}
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	GLint status = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		char log[1024];
+		glGetProgramInfoLog(program, sizeof(log), 0, log);
+		std::cout << " Error! Failed to link " << name << " shader: " << log << std::endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
@@ -0,0 +1,217 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#include "snapshot.hpp"
+#include "minefield.hpp"
+
+namespace {
+
+const char headerMagic[4] = { 'O', 'T', 'S', 'S' };
+
+const uint64_t snapshotVersion = 1;
+
+// Bit-planes are stored in host byte order, so the header records it
+const uint64_t byteOrderMark = 0x0102030405060708ULL;
+
+// Header words (after the magic and version)
+enum HeaderWords {
+	HEADER_BYTE_ORDER = 1,
+	HEADER_WIDTH,
+	HEADER_HEIGHT,
+	HEADER_MINES,
+	HEADER_FLAGS,
+	HEADER_TIME,
+	HEADER_ROW_WORDS
+};
+
+const uint64_t minesPlacedFlag = 1;
+
+// Topology is stored in bits 8-15 of the flags, and the rows in each layer of a cubic minefield in bits 32-63
+// (both are zero for a square minefield, as in snapshots saved before other topologies were supported)
+const int topologyShift = 8;
+
+const int layerRowsShift = 32;
+
+void writeWord(uint8_t* data, const uint64_t& value) {
+	for (int i = 0; i < 8; i++) { // Little endian
+		data[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+uint64_t readWord(const uint8_t* data) {
+	uint64_t value = 0;
+	for (int i = 0; i < 8; i++) {
+		value |= (uint64_t)data[i] << (8 * i);
+	}
+	return value;
+}
+
+} // namespace
+
+Snapshot::Snapshot() :
+	data(0x0),
+	nSize(0),
+	nWidth(0),
+	nHeight(0),
+	nMines(0),
+	topology(Topologies::SQUARE),
+	nLayerRows(0),
+	bMinesPlaced(false),
+	nTime(0),
+	nPlaneWords(0),
+	fileData()
+{
+}
+
+Snapshot::~Snapshot() {
+	close();
+}
+
+bool Snapshot::save(const std::string& fname, const Minefield& field, const double& time) {
+	if (field.getState() != GameStates::NORMAL)
+		return false;
+
+	// Header
+	uint8_t header[headerSize] = { 0 };
+	std::memcpy(header, headerMagic, 4);
+	writeWord(header + 4, snapshotVersion); // Version fills the rest of the first word
+	std::memcpy(header + 8 * HEADER_BYTE_ORDER, &byteOrderMark, 8);
+	writeWord(header + 8 * HEADER_WIDTH, (uint64_t)field.getWidth());
+	writeWord(header + 8 * HEADER_HEIGHT, (uint64_t)field.getHeight());
+	writeWord(header + 8 * HEADER_MINES, (uint64_t)field.getBombs());
+	const int nLayerRows = (field.getTopology() == Topologies::CUBIC ? field.getTopologyGrid().nLayerRows : 0);
+	writeWord(header + 8 * HEADER_FLAGS, (field.isFirstCell() ? 0 : minesPlacedFlag) | ((uint64_t)field.getTopology() << topologyShift) | ((uint64_t)nLayerRows << layerRowsShift));
+	writeWord(header + 8 * HEADER_TIME, (uint64_t)(time * 1E3));
+	writeWord(header + 8 * HEADER_ROW_WORDS, (uint64_t)(field.getPlaneWords() / (field.getHeight() > 0 ? field.getHeight() : 1)));
+
+	// Mine and cover state bit-planes
+	const size_t nWords = field.getPlaneWords();
+	std::vector<uint64_t> planes(4 * nWords, 0);
+	if (!field.isFirstCell()) {
+		field.saveMines(planes.data());
+		field.saveState(planes.data() + nWords);
+	}
+
+	std::ofstream ofile(fname.c_str(), std::ios::binary);
+	ofile.write((const char*)header, headerSize);
+	ofile.write((const char*)planes.data(), planes.size() * sizeof(uint64_t));
+	ofile.close();
+	if (!ofile.good()) {
+		std::cout << " Error! Failed to write snapshot file (" << fname << ")." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Snapshot::open(const std::string& fname) {
+	close();
+#ifndef _WIN32
+	const int fd = ::open(fname.c_str(), O_RDONLY);
+	if (fd >= 0) {
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			void* mapped = mmap(0x0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped != MAP_FAILED) {
+				data = (const uint8_t*)mapped;
+				nSize = (size_t)info.st_size;
+			}
+		}
+		::close(fd);
+	}
+#else
+	std::ifstream ifile(fname.c_str(), std::ios::binary);
+	if (ifile.good()) {
+		ifile.seekg(0, std::ios::end);
+		const size_t nFileSize = (size_t)ifile.tellg();
+		ifile.seekg(0, std::ios::beg);
+		fileData.resize(nFileSize + 8); // Room to align the planes to whole words
+		const size_t nAlign = (8 - (size_t)fileData.data() % 8) % 8;
+		if (nFileSize > 0 && ifile.read((char*)fileData.data() + nAlign, nFileSize)) {
+			data = fileData.data() + nAlign;
+			nSize = nFileSize;
+		}
+	}
+#endif
+	if (!data) {
+		std::cout << " Error! Failed to open snapshot file (" << fname << ")." << std::endl;
+		return false;
+	}
+
+	// Header
+	uint64_t order = 0;
+	if (nSize >= headerSize)
+		std::memcpy(&order, data + 8 * HEADER_BYTE_ORDER, 8);
+	if (nSize < headerSize || std::memcmp(data, headerMagic, 4) != 0 || (readWord(data + 4) & 0xffffffffULL) != snapshotVersion || order != byteOrderMark) {
+		std::cout << " Error! Invalid snapshot file (" << fname << ")." << std::endl;
+		close();
+		return false;
+	}
+	const uint64_t width = readWord(data + 8 * HEADER_WIDTH);
+	const uint64_t height = readWord(data + 8 * HEADER_HEIGHT);
+	const uint64_t mines = readWord(data + 8 * HEADER_MINES);
+	const uint64_t rowWords = readWord(data + 8 * HEADER_ROW_WORDS);
+	const uint64_t flags = readWord(data + 8 * HEADER_FLAGS);
+	const uint64_t type = (flags >> topologyShift) & 0xff;
+	const uint64_t layerRows = flags >> layerRowsShift;
+	if (width == 0 || height == 0 || width * height > 0x7fffffffULL || mines >= width * height || rowWords != (width + 63) / 64 ||
+	    nSize != headerSize + 4 * 8 * rowWords * height || type > (uint64_t)Topologies::CUBIC || layerRows > height) {
+		std::cout << " Error! Corrupt snapshot file (" << fname << ")." << std::endl;
+		close();
+		return false;
+	}
+	nWidth = (int)width;
+	nHeight = (int)height;
+	nMines = (int)mines;
+	topology = (Topologies)type;
+	nLayerRows = (int)layerRows;
+	bMinesPlaced = ((flags & minesPlacedFlag) != 0);
+	nTime = readWord(data + 8 * HEADER_TIME);
+	nPlaneWords = (size_t)(rowWords * height);
+	return true;
+}
+
+void Snapshot::close() {
+#ifndef _WIN32
+	if (data && fileData.empty())
+		munmap((void*)data, nSize);
+#endif
+	data = 0x0;
+	nSize = 0;
+	nWidth = 0;
+	nHeight = 0;
+	nMines = 0;
+	topology = Topologies::SQUARE;
+	nLayerRows = 0;
+	bMinesPlaced = false;
+	nTime = 0;
+	nPlaneWords = 0;
+	fileData.clear();
+}
+
+bool Snapshot::restore(Minefield& field) const {
+	if (!data)
+		return false;
+	if (field.getWidth() != nWidth || field.getHeight() != nHeight || field.getBombs() != nMines)
+		field.setSize(nWidth, nHeight, nMines);
+	if (field.getTopology() != topology || (topology == Topologies::CUBIC && field.getTopologyGrid().nLayerRows != nLayerRows)) {
+		if (!field.setTopology(topology, nLayerRows))
+			return false;
+	}
+	field.resetField();
+	if (!bMinesPlaced) // Saved before the first move
+		return true;
+	if (!field.loadMines(getPlane(0)) || !field.loadState(getPlane(1))) {
+		std::cout << " Error! Invalid minefield in snapshot file." << std::endl;
+		field.resetField();
+		return false;
+	}
+	return true;
+}
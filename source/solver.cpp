@@ -0,0 +1,397 @@
+#include <algorithm>
+
+#include "solver.hpp"
+#include "minefield.hpp"
+#include "bitplane.hpp"
+
+void CellSet::reset(const int& nCells) {
+	cells.clear();
+	cells.reserve(nCells);
+	positions.assign(nCells, -1);
+}
+
+void CellSet::insert(const int& cell) {
+	if (positions[cell] >= 0)
+		return;
+	positions[cell] = (int)cells.size();
+	cells.push_back(cell);
+}
+
+void CellSet::erase(const int& cell) {
+	const int position = positions[cell];
+	if (position < 0)
+		return;
+	const int last = cells.back(); // Move the last cell into the hole
+	cells[position] = last;
+	positions[last] = position;
+	cells.pop_back();
+	positions[cell] = -1;
+}
+
+Solver::Solver() :
+	nSizeX(0),
+	nSizeY(0),
+	topology(Topologies::SQUARE),
+	grid(),
+	nRevealedCells(0),
+	states(),
+	numbers(),
+	remaining(),
+	hidden(),
+	queued(),
+	workQueue(),
+	frontier(),
+	safeCells(),
+	mineCells()
+{
+}
+
+void Solver::reset(const int& width, const int& height, const Topologies& type/*=Topologies::SQUARE*/, const int& layerRows/*=0*/) {
+	const int nCells = width * height;
+	nSizeX = width;
+	nSizeY = height;
+	topology = type;
+	grid.nSizeX = width;
+	grid.nSizeY = height;
+	grid.nLayerRows = (layerRows > 0 ? layerRows : height);
+	nRevealedCells = 0;
+	states.assign(nCells, (unsigned char)SolverStates::HIDDEN);
+	numbers.assign(nCells, 0);
+	remaining.assign(nCells, 0);
+	hidden.assign(nCells, 0);
+	queued.assign(nCells, 0);
+	workQueue.clear();
+	workQueue.reserve(nCells);
+	frontier.reset(nCells);
+	safeCells.reset(nCells);
+	mineCells.clear();
+	mineCells.reserve(nCells);
+}
+
+void Solver::update(const Minefield& field) {
+	if (field.isFullUpdate() || field.getWidth() != nSizeX || field.getHeight() != nSizeY || field.getTopology() != topology) {
+		rebuild(field);
+		return;
+	}
+	if (field.getState() != GameStates::NORMAL) // Nothing left to solve
+		return;
+	const std::vector<int>& changedCells = field.getChangedCells();
+	for (auto cell = changedCells.begin(); cell != changedCells.end(); cell++) {
+		if (field.getCover(*cell) != 0) {
+			if (states[*cell] == (unsigned char)SolverStates::REVEALED) { // Covered again by an undo
+				rebuild(field);
+				return;
+			}
+			continue; // Flags are ignored, they may be wrong
+		}
+		reveal(field, *cell);
+	}
+	solve();
+}
+
+void Solver::rebuild(const Minefield& field) {
+	reset(field.getWidth(), field.getHeight(), field.getTopology(), field.getTopologyGrid().nLayerRows);
+	if (field.getState() != GameStates::NORMAL || field.isFirstCell())
+		return;
+	const int nCells = nSizeX * nSizeY;
+	for (int i = 0; i < nCells; i++) {
+		if (field.getCover(i) == 0)
+			reveal(field, i);
+	}
+	solve();
+}
+
+int Solver::getNeighbors(const int& cell, int* neighbors) const {
+	switch (topology) {
+	case Topologies::TORUS:
+		return TorusTopology::getNeighbors(grid, cell % nSizeX, cell / nSizeX, neighbors);
+	case Topologies::HEX:
+		return HexTopology::getNeighbors(grid, cell % nSizeX, cell / nSizeX, neighbors);
+	case Topologies::CUBIC:
+		return CubicTopology::getNeighbors(grid, cell % nSizeX, cell / nSizeX, neighbors);
+	default:
+		break;
+	}
+	return SquareTopology::getNeighbors(grid, cell % nSizeX, cell / nSizeX, neighbors);
+}
+
+void Solver::reveal(const Minefield& field, const int& cell) {
+	const SolverStates previous = (SolverStates)states[cell];
+	if (previous == SolverStates::REVEALED)
+		return;
+	int neighbors[nMaxTopologyNeighbors];
+	const int nNeighbors = getNeighbors(cell, neighbors);
+	if (previous == SolverStates::HIDDEN) { // Cell is no longer unknown to its neighbors
+		frontier.erase(cell);
+		for (int i = 0; i < nNeighbors; i++) {
+			if (states[neighbors[i]] == (unsigned char)SolverStates::REVEALED) {
+				hidden[neighbors[i]]--;
+				enqueue(neighbors[i]);
+			}
+		}
+	}
+	else if (previous == SolverStates::SAFE) {
+		safeCells.erase(cell);
+	}
+	states[cell] = (unsigned char)SolverStates::REVEALED;
+	numbers[cell] = field.getCell(cell);
+	nRevealedCells++;
+
+	// Build the constraint for the new number
+	int nMines = 0;
+	int nHidden = 0;
+	for (int i = 0; i < nNeighbors; i++) {
+		switch ((SolverStates)states[neighbors[i]]) {
+		case SolverStates::HIDDEN:
+			nHidden++;
+			frontier.insert(neighbors[i]);
+			break;
+		case SolverStates::MINE:
+			nMines++;
+			break;
+		default:
+			break;
+		}
+	}
+	remaining[cell] = (unsigned char)(numbers[cell] > nMines ? numbers[cell] - nMines : 0);
+	hidden[cell] = (unsigned char)nHidden;
+	enqueue(cell);
+}
+
+void Solver::setSafe(const int& cell) {
+	if (states[cell] != (unsigned char)SolverStates::HIDDEN)
+		return;
+	states[cell] = (unsigned char)SolverStates::SAFE;
+	frontier.erase(cell);
+	safeCells.insert(cell);
+	int neighbors[nMaxTopologyNeighbors];
+	const int nNeighbors = getNeighbors(cell, neighbors);
+	for (int i = 0; i < nNeighbors; i++) {
+		if (states[neighbors[i]] == (unsigned char)SolverStates::REVEALED) {
+			hidden[neighbors[i]]--;
+			enqueue(neighbors[i]);
+		}
+	}
+}
+
+void Solver::setMine(const int& cell) {
+	if (states[cell] != (unsigned char)SolverStates::HIDDEN)
+		return;
+	states[cell] = (unsigned char)SolverStates::MINE;
+	frontier.erase(cell);
+	mineCells.push_back(cell);
+	int neighbors[nMaxTopologyNeighbors];
+	const int nNeighbors = getNeighbors(cell, neighbors);
+	for (int i = 0; i < nNeighbors; i++) {
+		if (states[neighbors[i]] == (unsigned char)SolverStates::REVEALED) {
+			hidden[neighbors[i]]--;
+			if (remaining[neighbors[i]] > 0)
+				remaining[neighbors[i]]--;
+			enqueue(neighbors[i]);
+		}
+	}
+}
+
+void Solver::enqueue(const int& cell) {
+	if (queued[cell])
+		return;
+	queued[cell] = 1;
+	workQueue.push_back(cell);
+}
+
+template <class Topology>
+void Solver::solve() {
+	while (!workQueue.empty()) {
+		const int cell = workQueue.back();
+		workQueue.pop_back();
+		queued[cell] = 0;
+		if (checkConstraint<Topology>(cell)) // Check the cell again, it may allow more deductions
+			enqueue(cell);
+	}
+}
+
+uint64_t Solver::getHiddenMask(const int& cell, const int& dx, const int& dy) const {
+	const int x = cell % nSizeX;
+	const int y = cell / nSizeX;
+	uint64_t mask = 0;
+	for (int oy = -1; oy <= 1; oy++) {
+		if (y + oy < 0 || y + oy >= nSizeY)
+			continue;
+		for (int ox = -1; ox <= 1; ox++) {
+			if (x + ox < 0 || x + ox >= nSizeX || (ox == 0 && oy == 0))
+				continue;
+			if (states[(y + oy) * nSizeX + x + ox] == (unsigned char)SolverStates::HIDDEN)
+				mask |= 1ULL << ((dy + oy + 3) * 7 + (dx + ox + 3));
+		}
+	}
+	return mask;
+}
+
+void Solver::applyMask(const int& center, uint64_t mask, const bool& mines) {
+	const int x = center % nSizeX;
+	const int y = center / nSizeX;
+	while (mask) {
+		const int bit = BitPlane::lowestBit(mask);
+		mask &= mask - 1;
+		const int cell = (y + bit / 7 - 3) * nSizeX + (x + bit % 7 - 3);
+		if (mines)
+			setMine(cell);
+		else
+			setSafe(cell);
+	}
+}
+
+template <class Topology>
+int Solver::getHiddenCells(const int& cell, int* cells) const {
+	int neighbors[Topology::nMaxNeighbors];
+	const int nNeighbors = Topology::getNeighbors(grid, cell % nSizeX, cell / nSizeX, neighbors);
+	int count = 0;
+	for (int i = 0; i < nNeighbors; i++) {
+		if (states[neighbors[i]] == (unsigned char)SolverStates::HIDDEN)
+			cells[count++] = neighbors[i];
+	}
+	return count;
+}
+
+template <class Topology>
+bool Solver::checkConstraint(const int& cell) {
+	if (states[cell] != (unsigned char)SolverStates::REVEALED || hidden[cell] == 0)
+		return false;
+	int cellsA[Topology::nMaxNeighbors];
+	const int nA = getHiddenCells<Topology>(cell, cellsA);
+
+	// Single cell rule
+	if (remaining[cell] == 0 || remaining[cell] == hidden[cell]) { // All hidden neighbors are safe, or all are mines
+		const bool bMines = (remaining[cell] != 0);
+		for (int i = 0; i < nA; i++) {
+			if (bMines)
+				setMine(cellsA[i]);
+			else
+				setSafe(cellsA[i]);
+		}
+		return true;
+	}
+
+	// Subset rule, compare against every revealed cell sharing a hidden neighbor
+	int neighbors[Topology::nMaxNeighbors];
+	int cellsB[Topology::nMaxNeighbors];
+	int diff[Topology::nMaxNeighbors];
+	for (int a = 0; a < nA; a++) {
+		const int nNeighbors = Topology::getNeighbors(grid, cellsA[a] % nSizeX, cellsA[a] / nSizeX, neighbors);
+		for (int n = 0; n < nNeighbors; n++) {
+			const int other = neighbors[n];
+			if (other == cell || states[other] != (unsigned char)SolverStates::REVEALED || hidden[other] == 0)
+				continue;
+			const int nB = getHiddenCells<Topology>(other, cellsB);
+			int nShared = 0;
+			for (int i = 0; i < nA; i++) {
+				nShared += (int)(std::find(cellsB, cellsB + nB, cellsA[i]) != cellsB + nB);
+			}
+			if (nShared == nA && nA < nB) { // Hidden neighbors of this cell are a subset of the other's
+				const int nDiff = (int)(std::remove_copy_if(cellsB, cellsB + nB, diff, [&](const int& c) { return (std::find(cellsA, cellsA + nA, c) != cellsA + nA); }) - diff);
+				const int nMines = (int)remaining[other] - (int)remaining[cell];
+				if (nMines == 0 || nMines == nDiff) {
+					for (int i = 0; i < nDiff; i++) {
+						if (nMines == 0)
+							setSafe(diff[i]);
+						else
+							setMine(diff[i]);
+					}
+					return true;
+				}
+			}
+			else if (nShared == nB && nB < nA) { // Hidden neighbors of the other cell are a subset of this one's
+				const int nDiff = (int)(std::remove_copy_if(cellsA, cellsA + nA, diff, [&](const int& c) { return (std::find(cellsB, cellsB + nB, c) != cellsB + nB); }) - diff);
+				const int nMines = (int)remaining[cell] - (int)remaining[other];
+				if (nMines == 0 || nMines == nDiff) {
+					for (int i = 0; i < nDiff; i++) {
+						if (nMines == 0)
+							setSafe(diff[i]);
+						else
+							setMine(diff[i]);
+					}
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// Hidden neighbors are compared as masks of a 7x7 window, since every cell sharing one is within two cells
+template <>
+bool Solver::checkConstraint<SquareTopology>(const int& cell) {
+	if (states[cell] != (unsigned char)SolverStates::REVEALED || hidden[cell] == 0)
+		return false;
+
+	// Single cell rule
+	if (remaining[cell] == 0) { // All hidden neighbors are safe
+		applyMask(cell, getHiddenMask(cell, 0, 0), false);
+		return true;
+	}
+	if (remaining[cell] == hidden[cell]) { // All hidden neighbors are mines
+		applyMask(cell, getHiddenMask(cell, 0, 0), true);
+		return true;
+	}
+
+	// Subset rule, compare against every revealed cell which may share hidden neighbors
+	const int x = cell % nSizeX;
+	const int y = cell / nSizeX;
+	const uint64_t maskA = getHiddenMask(cell, 0, 0);
+	for (int dy = -2; dy <= 2; dy++) {
+		if (y + dy < 0 || y + dy >= nSizeY)
+			continue;
+		for (int dx = -2; dx <= 2; dx++) {
+			if (x + dx < 0 || x + dx >= nSizeX || (dx == 0 && dy == 0))
+				continue;
+			const int other = (y + dy) * nSizeX + x + dx;
+			if (states[other] != (unsigned char)SolverStates::REVEALED || hidden[other] == 0)
+				continue;
+			const uint64_t maskB = getHiddenMask(other, dx, dy);
+			if ((maskA & maskB) == 0)
+				continue;
+			if ((maskA & ~maskB) == 0 && maskA != maskB) { // Hidden neighbors of this cell are a subset of the other's
+				const uint64_t diff = maskB & ~maskA;
+				const int nMines = (int)remaining[other] - (int)remaining[cell];
+				if (nMines == 0) {
+					applyMask(cell, diff, false);
+					return true;
+				}
+				if (nMines == BitPlane::countBits(diff)) {
+					applyMask(cell, diff, true);
+					return true;
+				}
+			}
+			else if ((maskB & ~maskA) == 0 && maskA != maskB) { // Hidden neighbors of the other cell are a subset of this one's
+				const uint64_t diff = maskA & ~maskB;
+				const int nMines = (int)remaining[cell] - (int)remaining[other];
+				if (nMines == 0) {
+					applyMask(cell, diff, false);
+					return true;
+				}
+				if (nMines == BitPlane::countBits(diff)) {
+					applyMask(cell, diff, true);
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void Solver::solve() {
+	switch (topology) {
+	case Topologies::TORUS:
+		solve<TorusTopology>();
+		break;
+	case Topologies::HEX:
+		solve<HexTopology>();
+		break;
+	case Topologies::CUBIC:
+		solve<CubicTopology>();
+		break;
+	default:
+		solve<SquareTopology>();
+		break;
+	}
+}
@@ -0,0 +1,115 @@
+#include "threadpool.hpp"
+
+namespace {
+
+// Index of the pool queue owned by the current thread (or -1 for threads outside the pool)
+thread_local int currentWorker = -1;
+
+// Pool which owns the current thread
+thread_local const ThreadPool* currentPool = 0x0;
+
+} // namespace
+
+ThreadPool::ThreadPool(const unsigned int& nThreads/*=0*/) :
+	bStop(false),
+	nQueued(0),
+	nPending(0),
+	nNextQueue(0),
+	sleepLock(),
+	wake(),
+	done(),
+	queues(),
+	threads()
+{
+	unsigned int nWorkers = (nThreads > 0 ? nThreads : std::thread::hardware_concurrency());
+	if (nWorkers == 0)
+		nWorkers = 1;
+	for (unsigned int i = 0; i < nWorkers; i++) {
+		queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+	}
+	for (unsigned int i = 0; i < nWorkers; i++) {
+		threads.push_back(std::thread(&ThreadPool::workerLoop, this, (size_t)i));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	wait();
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		bStop = true;
+	}
+	wake.notify_all();
+	for (auto thread = threads.begin(); thread != threads.end(); thread++) {
+		thread->join();
+	}
+}
+
+void ThreadPool::push(const std::function<void()>& task) {
+	size_t index;
+	if (currentPool == this && currentWorker >= 0) // Push to the back of the worker's own queue
+		index = (size_t)currentWorker;
+	else // Distribute external tasks between the queues
+		index = nNextQueue++ % queues.size();
+	nPending++;
+	{
+		std::lock_guard<std::mutex> guard(queues[index]->lock);
+		queues[index]->tasks.push_back(task);
+	}
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		nQueued++;
+	}
+	wake.notify_one();
+}
+
+void ThreadPool::wait() {
+	// Help run tasks, starting with an arbitrary queue
+	while (nPending > 0 && runTask(0)) {
+	}
+	std::unique_lock<std::mutex> guard(sleepLock);
+	done.wait(guard, [this] { return (nPending == 0); });
+}
+
+bool ThreadPool::runTask(const size_t& index) {
+	std::function<void()> task;
+	for (size_t i = 0; i < queues.size() && !task; i++) {
+		TaskQueue& queue = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (queue.tasks.empty())
+			continue;
+		if (i == 0) { // Newest task from our own queue
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		else { // Steal the oldest task from another queue
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+	}
+	if (!task)
+		return false;
+	nQueued--;
+	task();
+	finishTask();
+	return true;
+}
+
+void ThreadPool::finishTask() {
+	if (--nPending == 0) {
+		std::lock_guard<std::mutex> guard(sleepLock);
+		done.notify_all();
+	}
+}
+
+void ThreadPool::workerLoop(const size_t& index) {
+	currentWorker = (int)index;
+	currentPool = this;
+	while (true) {
+		if (runTask(index))
+			continue;
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wake.wait(guard, [this] { return (bStop || nQueued > 0); });
+		if (bStop && nQueued == 0)
+			return;
+	}
+}
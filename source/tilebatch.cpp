@@ -0,0 +1,272 @@
+#include <GL/glew.h>
+
+#include <iostream>
+#include <algorithm>
+
+#include "tilebatch.hpp"
+#include "shader.hpp"
+
+// Maximum number of instances uploaded individually before uploading their whole index range instead
+const size_t maxInstanceUploads = 64;
+
+const char* vertexShaderSource =
+	"#version 330\n"
+	"layout(location = 0) in uint sprite;\n"
+	"uniform vec4 spriteRects[32];\n"
+	"uniform vec2 fixedPositions[7];\n"
+	"uniform vec2 screenSize;\n"
+	"uniform vec2 gridOrigin;\n"
+	"uniform int gridColumns;\n"
+	"uniform float tileSize;\n"
+	"uniform vec2 gridScroll;\n"
+	"uniform float gridScale;\n"
+	"uniform float gridRowShift;\n"
+	"uniform int gridFirstRow;\n"
+	"out vec2 atlasCoord;\n"
+	"out vec2 gridCoord;\n"
+	"flat out int gridInstance;\n"
+	"void main() {\n"
+	"	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+	"	vec4 rect = spriteRects[sprite];\n"
+	"	vec2 pos;\n"
+	"	if (gl_InstanceID < 7) {\n"
+	"		pos = fixedPositions[gl_InstanceID] + corner * rect.zw;\n"
+	"		gridCoord = vec2(0.0);\n"
+	"		gridInstance = 0;\n"
+	"	}\n"
+	"	else {\n"
+	"		int cell = gl_InstanceID - 7;\n"
+	"		float shift = float((cell / gridColumns + gridFirstRow) & 1) * gridRowShift;\n"
+	"		gridCoord = (vec2(cell % gridColumns, cell / gridColumns) * tileSize + vec2(shift, 0.0) + corner * rect.zw - gridScroll) * gridScale;\n"
+	"		pos = gridOrigin + gridCoord;\n"
+	"		gridInstance = 1;\n"
+	"	}\n"
+	"	atlasCoord = rect.xy + corner * rect.zw;\n"
+	"	gl_Position = vec4(2.0 * pos.x / screenSize.x - 1.0, 1.0 - 2.0 * pos.y / screenSize.y, 0.0, 1.0);\n"
+	"}\n";
+
+const char* fragmentShaderSource =
+	"#version 330\n"
+	"uniform sampler2D atlas;\n"
+	"uniform vec2 gridClip;\n"
+	"in vec2 atlasCoord;\n"
+	"in vec2 gridCoord;\n"
+	"flat in int gridInstance;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	if (gridInstance != 0 && (any(lessThan(gridCoord, vec2(0.0))) || any(greaterThanEqual(gridCoord, gridClip))))\n"
+	"		discard;\n"
+	"	color = texelFetch(atlas, ivec2(atlasCoord), 0);\n"
+	"}\n";
+
+TileBatch::TileBatch() :
+	nColumns(0),
+	nRows(0),
+	nTileSize(16),
+	nOriginX(0),
+	nOriginY(0),
+	nScrollX(0),
+	nScrollY(0),
+	dGridScale(1),
+	nClipWidth(0),
+	nClipHeight(0),
+	nRowShift(0),
+	nFirstRow(0),
+	nScreenWidth(1),
+	nScreenHeight(1),
+	nDirtyLow(0),
+	nDirtyHigh(0),
+	nProgram(0),
+	nVertexArray(0),
+	nInstanceBuffer(0),
+	nAtlasTexture(0),
+	spriteRects(),
+	fixedPositions(2 * nFixedInstances, 0.f),
+	instances(nFixedInstances, 0),
+	dirtyInstances()
+{
+}
+
+bool TileBatch::initialize(const unsigned char* atlas, const int& width, const int& height) {
+	if (!GLEW_VERSION_3_3) {
+		std::cout << " Error! Instanced tile rendering requires OpenGL 3.3." << std::endl;
+		return false;
+	}
+
+	// Compile shader program
+	nProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource, "tile");
+	if (nProgram == 0)
+		return false;
+
+	// Upload sprite atlas (nearest filtering, sampled with texelFetch)
+	glGenTextures(1, &nAtlasTexture);
+	glBindTexture(GL_TEXTURE_2D, nAtlasTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// Per-instance sprite index buffer
+	glGenVertexArrays(1, &nVertexArray);
+	glGenBuffers(1, &nInstanceBuffer);
+	glBindVertexArray(nVertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, nInstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, instances.size(), instances.data(), GL_DYNAMIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribIPointer(0, 1, GL_UNSIGNED_BYTE, 1, 0);
+	glVertexAttribDivisor(0, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return true;
+}
+
+int TileBatch::addSprites(const int& x0, const int& y0, const int& w, const int& h, const int& cols, const int& rows) {
+	const int first = (int)spriteRects.size() / 4;
+	for (int i = 0; i < cols * rows && first + i < nMaxSprites; i++) {
+		spriteRects.push_back((float)(x0 + (i % cols) * w));
+		spriteRects.push_back((float)(y0 + (i / cols) * h));
+		spriteRects.push_back((float)w);
+		spriteRects.push_back((float)h);
+	}
+	return first;
+}
+
+void TileBatch::setScreenSize(const int& width, const int& height) {
+	nScreenWidth = width;
+	nScreenHeight = height;
+}
+
+void TileBatch::setGrid(const int& x, const int& y, const int& cols, const int& rows, const int& tileSize) {
+	nOriginX = x;
+	nOriginY = y;
+	nColumns = cols;
+	nRows = rows;
+	nTileSize = tileSize;
+	nScrollX = 0;
+	nScrollY = 0;
+	dGridScale = 1;
+	nClipWidth = nColumns * nTileSize;
+	nClipHeight = nRows * nTileSize;
+	instances.resize(nFixedInstances + nColumns * nRows, 0);
+	dirtyInstances.reserve(instances.size());
+	if (nInstanceBuffer != 0) { // Reallocate instance buffer
+		glBindBuffer(GL_ARRAY_BUFFER, nInstanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, instances.size(), instances.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	dirtyInstances.clear();
+}
+
+void TileBatch::reserve(const int& cells) {
+	instances.reserve(nFixedInstances + cells);
+	dirtyInstances.reserve(nFixedInstances + cells);
+}
+
+void TileBatch::setGridView(const int& scrollX, const int& scrollY, const float& scale, const int& width, const int& height) {
+	nScrollX = scrollX;
+	nScrollY = scrollY;
+	dGridScale = scale;
+	nClipWidth = width;
+	nClipHeight = height;
+}
+
+void TileBatch::setRowShift(const int& shift, const int& firstRow) {
+	nRowShift = shift;
+	nFirstRow = firstRow;
+}
+
+void TileBatch::setCounterPosition(const int& counter, const int& x, const int& y) {
+	for (int digit = 0; digit < 3; digit++) {
+		fixedPositions[2 * (3 * counter + digit)] = (float)(x + 13 * digit);
+		fixedPositions[2 * (3 * counter + digit) + 1] = (float)y;
+	}
+}
+
+void TileBatch::setCounter(const int& counter, const int& value, const int& firstDigitSprite) {
+	const int clamped = std::max(0, std::min(999, value));
+	const int digits[3] = { clamped / 100, (clamped / 10) % 10, clamped % 10 };
+	for (int digit = 0; digit < 3; digit++) {
+		const int instance = 3 * counter + digit;
+		const unsigned char sprite = (unsigned char)(firstDigitSprite + digits[digit]);
+		if (instances[instance] != sprite) {
+			instances[instance] = sprite;
+			markDirty(instance);
+		}
+	}
+}
+
+void TileBatch::setFacePosition(const int& x, const int& y) {
+	fixedPositions[2 * nCounterDigits] = (float)x;
+	fixedPositions[2 * nCounterDigits + 1] = (float)y;
+}
+
+void TileBatch::setFace(const int& sprite) {
+	if (instances[nCounterDigits] == (unsigned char)sprite)
+		return;
+	instances[nCounterDigits] = (unsigned char)sprite;
+	markDirty(nCounterDigits);
+}
+
+void TileBatch::setTile(const int& index, const unsigned char& sprite) {
+	const int instance = nFixedInstances + index;
+	if (instances[instance] == sprite)
+		return;
+	instances[instance] = sprite;
+	markDirty(instance);
+}
+
+void TileBatch::draw() {
+	if (!isReady())
+		return;
+	upload();
+	glUseProgram(nProgram);
+	glUniform4fv(glGetUniformLocation(nProgram, "spriteRects"), (GLsizei)spriteRects.size() / 4, spriteRects.data());
+	glUniform2fv(glGetUniformLocation(nProgram, "fixedPositions"), nFixedInstances, fixedPositions.data());
+	glUniform2f(glGetUniformLocation(nProgram, "screenSize"), (float)nScreenWidth, (float)nScreenHeight);
+	glUniform2f(glGetUniformLocation(nProgram, "gridOrigin"), (float)nOriginX, (float)nOriginY);
+	glUniform1i(glGetUniformLocation(nProgram, "gridColumns"), std::max(1, nColumns));
+	glUniform1f(glGetUniformLocation(nProgram, "tileSize"), (float)nTileSize);
+	glUniform2f(glGetUniformLocation(nProgram, "gridScroll"), (float)nScrollX, (float)nScrollY);
+	glUniform1f(glGetUniformLocation(nProgram, "gridScale"), (float)dGridScale);
+	glUniform2f(glGetUniformLocation(nProgram, "gridClip"), (float)nClipWidth, (float)nClipHeight);
+	glUniform1f(glGetUniformLocation(nProgram, "gridRowShift"), (float)nRowShift);
+	glUniform1i(glGetUniformLocation(nProgram, "gridFirstRow"), nFirstRow);
+	glUniform1i(glGetUniformLocation(nProgram, "atlas"), 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, nAtlasTexture);
+	glBindVertexArray(nVertexArray);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instances.size());
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+}
+
+void TileBatch::markDirty(const int& instance) {
+	if (dirtyInstances.empty()) {
+		nDirtyLow = instance;
+		nDirtyHigh = instance;
+	}
+	else {
+		nDirtyLow = std::min(nDirtyLow, instance);
+		nDirtyHigh = std::max(nDirtyHigh, instance);
+	}
+	dirtyInstances.push_back(instance);
+}
+
+void TileBatch::upload() {
+	if (dirtyInstances.empty())
+		return;
+	glBindBuffer(GL_ARRAY_BUFFER, nInstanceBuffer);
+	if (dirtyInstances.size() <= maxInstanceUploads) { // Upload each instance
+		for (auto instance = dirtyInstances.begin(); instance != dirtyInstances.end(); instance++) {
+			glBufferSubData(GL_ARRAY_BUFFER, *instance, 1, &instances[*instance]);
+		}
+	}
+	else { // Upload the range of all modified instances
+		glBufferSubData(GL_ARRAY_BUFFER, nDirtyLow, nDirtyHigh - nDirtyLow + 1, &instances[nDirtyLow]);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	dirtyInstances.clear();
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+
+#include "tileview.hpp"
+#include "minefield.hpp"
+
+TileView::TileView() :
+	bFullRedraw(true),
+	nPressedCell(-1),
+	tiles(),
+	dirtyCells(),
+	highlightCells(),
+	previousCells()
+{
+}
+
+void TileView::update(const Minefield& field, const int& pressedCell, const std::vector<int>& previewCells) {
+	const int nCells = field.getCells();
+	if ((int)tiles.size() != nCells) { // Minefield was resized
+		tiles.assign(nCells, 0);
+		dirtyCells.reserve(nCells);
+		highlightCells.reserve(10); // Pressed cell and its neighbors, plus the previously pressed cell
+		previousCells.reserve(10);
+		bFullRedraw = true;
+	}
+
+	// Cells which were highlighted on the previous update (swapping keeps both buffers allocated)
+	previousCells.swap(highlightCells);
+	highlightCells.clear();
+	if (nPressedCell >= 0)
+		previousCells.push_back(nPressedCell);
+
+	// Set new highlighted cells
+	nPressedCell = (pressedCell >= 0 && pressedCell < nCells ? pressedCell : -1);
+	highlightCells.assign(previewCells.begin(), previewCells.end());
+
+	if (bFullRedraw || field.isFullUpdate()) { // Recompute every cell
+		bFullRedraw = true;
+		dirtyCells.clear();
+		for (int i = 0; i < nCells; i++) {
+			tiles[i] = getTile(field, i);
+		}
+		return;
+	}
+
+	// Only check cells which may have changed
+	const std::vector<int>& changedCells = field.getChangedCells();
+	for (auto cell = changedCells.begin(); cell != changedCells.end(); cell++) {
+		updateCell(field, *cell);
+	}
+	for (auto cell = previousCells.begin(); cell != previousCells.end(); cell++) {
+		updateCell(field, *cell);
+	}
+	for (auto cell = highlightCells.begin(); cell != highlightCells.end(); cell++) {
+		updateCell(field, *cell);
+	}
+	if (nPressedCell >= 0)
+		updateCell(field, nPressedCell);
+}
+
+void TileView::clearDirty() {
+	dirtyCells.clear();
+	bFullRedraw = false;
+}
+
+unsigned char TileView::selectTile(const unsigned char& cover, const unsigned char& cell, const bool& highlighted) {
+	switch (cover) {
+	case 0: // Tile is revealed
+		return cell;
+	case 2: // Flagged cell
+		return Minefield::getDefaultTileValue(TileTypes::FLAGGED);
+	default: // Tile is hidden
+		break;
+	}
+	if (highlighted) // Pressed, or surrounding a cell while the right mouse button is held
+		return Minefield::getDefaultTileValue(TileTypes::ZERO);
+	if (cover == 3) // Question mark cell
+		return Minefield::getDefaultTileValue(TileTypes::UNKNOWN);
+	return Minefield::getDefaultTileValue(TileTypes::NORMAL); // Normal cell
+}
+
+unsigned char TileView::getTile(const Minefield& field, const int& index) const {
+	return selectTile(field.getCover(index), field.getCell(index), isHighlighted(index));
+}
+
+bool TileView::isHighlighted(const int& index) const {
+	if (index == nPressedCell)
+		return true;
+	return (std::find(highlightCells.begin(), highlightCells.end(), index) != highlightCells.end());
+}
+
+void TileView::updateCell(const Minefield& field, const int& index) {
+	const unsigned char tile = getTile(field, index);
+	if (tile == tiles[index])
+		return;
+	tiles[index] = tile;
+	dirtyCells.push_back(index);
+}